@@ -0,0 +1,116 @@
+#ifndef BENCH_ENGINES_H
+#define BENCH_ENGINES_H
+
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include "hash.cpp"
+
+// Key-set engines the benchmarks compare: HashTable itself and
+// std::unordered_multiset baselines behind one global lock. An engine is built
+// from the bucket count and the key count and provides insert, read, remove
+// and footprint(); add one here, to engineNames and to withEngine() to have
+// every benchmark run it.
+
+struct TableEngine {
+    HashTable table;
+    TableEngine(size_t buckets, size_t): table(buckets) {}
+    void insert(std::string_view key) { table.insert(key); }
+    bool read(std::string_view key) { return table.read(key); }
+    void remove(std::string_view key) { table.remove(key); }
+    TableFootprint footprint() { return table.footprint(); }
+};
+
+// Same hash as HashTable, usable for lookups by string_view.
+struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+};
+
+// Multiset, since HashTable keeps a duplicate for every INSERT too.
+using KeySet = std::unordered_multiset<std::string, KeyHash, std::equal_to<>>;
+
+// libstdc++ keeps a node per key (next pointer, cached hash, value) and an
+// array of bucket pointers; the caller holds the set's lock.
+inline TableFootprint setFootprint(const KeySet& set, size_t lockBytes) {
+    const size_t node = sizeof(void*) + sizeof(size_t) + sizeof(std::string);
+    TableFootprint footprint;
+    footprint.keys = set.size();
+    footprint.bucketArray = set.bucket_count() * sizeof(void*);
+    footprint.locks = lockBytes;
+    footprint.listNodes = set.size() * (sizeof(void*) + sizeof(size_t));
+    footprint.stringHeaders = set.size() * sizeof(std::string);
+    if (set.bucket_count() > 1) addBlock(footprint, set.bucket_count() * sizeof(void*));
+    for (const std::string& item : set) {
+        addBlock(footprint, node);
+        if (onHeap(item)) {
+            footprint.keyBytes += item.capacity() + 1;
+            addBlock(footprint, item.capacity() + 1);
+        }
+    }
+    return footprint;
+}
+
+struct MutexSetEngine {
+    std::mutex lock;
+    KeySet set;
+    MutexSetEngine(size_t buckets, size_t) { set.rehash(buckets); }
+    void insert(std::string_view key) {
+        std::lock_guard<std::mutex> guard(lock);
+        set.emplace(key);
+    }
+    bool read(std::string_view key) {
+        std::lock_guard<std::mutex> guard(lock);
+        return set.find(key) != set.end();
+    }
+    void remove(std::string_view key) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = set.find(key);
+        if (found != set.end()) set.erase(found);
+    }
+    TableFootprint footprint() {
+        std::lock_guard<std::mutex> guard(lock);
+        return setFootprint(set, sizeof(lock));
+    }
+};
+
+struct RwlockSetEngine {
+    std::shared_mutex lock;
+    KeySet set;
+    RwlockSetEngine(size_t buckets, size_t) { set.rehash(buckets); }
+    void insert(std::string_view key) {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        set.emplace(key);
+    }
+    bool read(std::string_view key) {
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return set.find(key) != set.end();
+    }
+    void remove(std::string_view key) {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        auto found = set.find(key);
+        if (found != set.end()) set.erase(found);
+    }
+    TableFootprint footprint() {
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return setFootprint(set, sizeof(lock));
+    }
+};
+
+const char* engineNames[] = {"table", "mutex-set", "rwlock-set"};
+
+// Calls visit.template operator()<Engine>() for the engine called `name`;
+// false if there is none.
+template <typename Visitor>
+bool withEngine(const std::string& name, Visitor visit) {
+    if (name == "table") visit.template operator()<TableEngine>();
+    else if (name == "mutex-set") visit.template operator()<MutexSetEngine>();
+    else if (name == "rwlock-set") visit.template operator()<RwlockSetEngine>();
+    else return false;
+    return true;
+}
+
+#endif
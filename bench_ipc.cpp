@@ -0,0 +1,464 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "datatypes.hpp"
+#include "histogram.hpp"
+
+// Client <-> server hand-off benchmark with no table work. The server is a
+// forked process that echoes every request; 1 to --max-requesters threads in
+// this process each keep one request in flight (ping-pong) for --duration
+// seconds, after a warm-up. Reports round trips per second and the round-trip
+// latency distribution for every transport:
+//
+//   sem-slot      the single SharedMemory slot and its four semaphores (the default mode)
+//   ring-sem      per-requester slots, indices on a shared BoundedRing, submission
+//                 Doorbell, sem_t completion (the zero-copy mode)
+//   ring-futex    same, with a Doorbell both ways
+//   ring-spin     same, both sides spinning and never sleeping (busy-poll without parking)
+//   ring-eventfd  same, with an eventfd write and read for every wake-up
+//   pipe          a pipe pair per requester, server on epoll
+//   unix          a Unix stream socketpair per requester, server on epoll
+//
+//   ./bench_ipc [--transports a,b,..] [--max-requesters 64] [--duration s] [--json file]
+
+#define MAX_REQUESTERS 64
+#define IPC_RING_DEPTH 64
+#define DEFAULT_IPC_SECONDS 0.5
+#define IPC_WARMUP_SECONDS 0.1
+#define BENCH_KEY "pingpong"
+
+template <typename T>
+T* mapShared() {
+    void* mapping = mmap(NULL, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    return (T*)mapping;
+}
+
+inline void fillRequest(Request& request, uint64_t id) {
+    request.requestid = id;
+    request.operation = READ;
+    memcpy(request.value, BENCH_KEY, sizeof(BENCH_KEY));
+}
+
+inline void fillResponse(Response& response, const Request& request) {
+    response.requestid = request.requestid;
+    response.returntype = SUCCESS;
+    response.result = true;
+}
+
+// The default mode's protocol, as the client and server use it: requesters
+// take turns on the one request slot, and pass each other's responses on
+// until their own comes back.
+class SemSlotTransport {
+
+    private:
+
+        SharedMemory* shm;
+
+    public:
+
+        explicit SemSlotTransport(int) {
+            shm = mapShared<SharedMemory>();
+            sem_init(&shm->req_available, 1, 0);
+            sem_init(&shm->req_space_available, 1, 1);
+            sem_init(&shm->res_available, 1, 0);
+            sem_init(&shm->res_space_available, 1, 1);
+        }
+
+        ~SemSlotTransport() { munmap(shm, sizeof(SharedMemory)); }
+
+        void serve() {
+            Request request;
+            while (true) {
+                sem_wait(&shm->req_available);
+                request = shm->request;
+                sem_post(&shm->req_space_available);
+                sem_wait(&shm->res_space_available);
+                fillResponse(shm->response, request);
+                sem_post(&shm->res_available);
+            }
+        }
+
+        void roundTrip(int, uint64_t id) {
+            Request request;
+            fillRequest(request, id);
+            sem_wait(&shm->req_space_available);
+            shm->request = request;
+            sem_post(&shm->req_available);
+            while (true) {
+                sem_wait(&shm->res_available);
+                if (shm->response.requestid == id) break;
+                sem_post(&shm->res_available);
+            }
+            sem_post(&shm->res_space_available);
+        }
+};
+
+enum RingWake {
+    WAKE_SEM,
+    WAKE_FUTEX,
+    WAKE_SPIN,
+    WAKE_EVENTFD
+};
+
+// Per-requester slots in shm, with requester indices handed to the server on
+// a shared ring; only how each side waits differs.
+template <RingWake wake>
+class RingTransport {
+
+    private:
+
+        struct alignas(64) Box {
+            Request request;
+            Response response;
+            std::atomic<uint32_t> done;
+            sem_t doneSem;
+            Doorbell doneBell;
+        };
+
+        struct Shared {
+            BoundedRing<uint32_t, IPC_RING_DEPTH> submitted;
+            alignas(64) Doorbell serverBell;
+            Box boxes[MAX_REQUESTERS];
+        };
+
+        Shared* shared;
+        int serverFd = -1;
+        int doneFds[MAX_REQUESTERS];
+        int requesters;
+
+        static void signal(int fd) {
+            uint64_t one = 1;
+            if (write(fd, &one, sizeof(one)) != sizeof(one)) perror("eventfd write");
+        }
+
+        static void await(int fd) {
+            uint64_t count;
+            if (read(fd, &count, sizeof(count)) != sizeof(count)) perror("eventfd read");
+        }
+
+    public:
+
+        explicit RingTransport(int requesters): requesters(requesters) {
+            shared = mapShared<Shared>();
+            shared->submitted.init();
+            shared->serverBell.init();
+            for (int i = 0; i < requesters; i++) {
+                shared->boxes[i].done.store(0);
+                sem_init(&shared->boxes[i].doneSem, 1, 0);
+                shared->boxes[i].doneBell.init();
+                doneFds[i] = wake == WAKE_EVENTFD ? eventfd(0, EFD_CLOEXEC) : -1;
+            }
+            if (wake == WAKE_EVENTFD) serverFd = eventfd(0, EFD_CLOEXEC);
+        }
+
+        ~RingTransport() {
+            for (int i = 0; i < requesters; i++) if (doneFds[i] >= 0) close(doneFds[i]);
+            if (serverFd >= 0) close(serverFd);
+            munmap(shared, sizeof(Shared));
+        }
+
+        void serve() {
+            uint32_t index;
+            while (true) {
+                if (wake == WAKE_SPIN) {
+                    while (!shared->submitted.pop(index)) cpuRelax();
+                }
+                else if (wake == WAKE_EVENTFD) {
+                    // One read covers every write so far, so drain the ring before the next.
+                    while (!shared->submitted.pop(index)) await(serverFd);
+                }
+                else {
+                    spinThenPark(shared->serverBell, 0, [&]() { return shared->submitted.pop(index); });
+                }
+
+                Box& box = shared->boxes[index];
+                fillResponse(box.response, box.request);
+                if (wake == WAKE_SEM) sem_post(&box.doneSem);
+                else if (wake == WAKE_EVENTFD) signal(doneFds[index]);
+                else {
+                    box.done.store(1, std::memory_order_release);
+                    if (wake == WAKE_FUTEX) box.doneBell.ring();
+                }
+            }
+        }
+
+        void roundTrip(int requester, uint64_t id) {
+            Box& box = shared->boxes[requester];
+            fillRequest(box.request, id);
+            box.done.store(0, std::memory_order_relaxed);
+            while (!shared->submitted.push(requester)) cpuRelax();
+            if (wake == WAKE_EVENTFD) signal(serverFd);
+            else if (wake != WAKE_SPIN) shared->serverBell.ring();
+
+            if (wake == WAKE_SEM) sem_wait(&box.doneSem);
+            else if (wake == WAKE_EVENTFD) await(doneFds[requester]);
+            else if (wake == WAKE_SPIN) {
+                while (box.done.load(std::memory_order_acquire) == 0) cpuRelax();
+            }
+            else spinThenPark(box.doneBell, 0, [&]() { return box.done.load(std::memory_order_acquire) != 0; });
+        }
+};
+
+// A request and a response channel per requester: two pipes, or one socketpair
+// used both ways. The server waits on all of them with epoll, like the socket
+// frontend, and answers in the wire protocol's frames.
+template <bool socketPair>
+class StreamTransport {
+
+    private:
+
+        int requestRead[MAX_REQUESTERS];
+        int requestWrite[MAX_REQUESTERS];
+        int responseRead[MAX_REQUESTERS];
+        int responseWrite[MAX_REQUESTERS];
+        int requesters;
+
+        struct __attribute__((packed)) Frame {
+            WireRequestHeader header;
+            char key[sizeof(BENCH_KEY) - 1];
+        };
+
+        static bool readFull(int fd, void* buffer, size_t size) {
+            char* bytes = (char*)buffer;
+            while (size > 0) {
+                ssize_t got = read(fd, bytes, size);
+                if (got <= 0) return false;
+                bytes += got;
+                size -= got;
+            }
+            return true;
+        }
+
+    public:
+
+        explicit StreamTransport(int requesters): requesters(requesters) {
+            for (int i = 0; i < requesters; i++) {
+                int request[2];
+                int response[2];
+                bool opened = socketPair ? socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, request) == 0
+                                         : pipe2(request, O_CLOEXEC) == 0 && pipe2(response, O_CLOEXEC) == 0;
+                if (!opened) {
+                    perror(socketPair ? "socketpair" : "pipe");
+                    exit(1);
+                }
+                // A socketpair is full duplex: the requester end talks, the server end answers.
+                requestWrite[i] = request[0];
+                requestRead[i] = request[1];
+                responseRead[i] = socketPair ? request[0] : response[0];
+                responseWrite[i] = socketPair ? request[1] : response[1];
+                if (!socketPair) std::swap(requestWrite[i], requestRead[i]);
+            }
+        }
+
+        ~StreamTransport() {
+            for (int i = 0; i < requesters; i++) {
+                close(requestRead[i]);
+                close(requestWrite[i]);
+                if (!socketPair) {
+                    close(responseRead[i]);
+                    close(responseWrite[i]);
+                }
+            }
+        }
+
+        void serve() {
+            int epollFd = epoll_create1(0);
+            for (int i = 0; i < requesters; i++) {
+                epoll_event event = {};
+                event.events = EPOLLIN;
+                event.data.u32 = i;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, requestRead[i], &event);
+            }
+            epoll_event events[MAX_REQUESTERS];
+            while (true) {
+                int ready = epoll_wait(epollFd, events, MAX_REQUESTERS, -1);
+                for (int e = 0; e < ready; e++) {
+                    int i = events[e].data.u32;
+                    Frame frame;
+                    if (!readFull(requestRead[i], &frame, sizeof(frame))) _exit(1);
+                    WireResponse response = {frame.header.requestid, SUCCESS, 1};
+                    if (write(responseWrite[i], &response, sizeof(response)) != sizeof(response)) _exit(1);
+                }
+            }
+        }
+
+        void roundTrip(int requester, uint64_t id) {
+            Frame frame;
+            frame.header = {id, READ, (uint8_t)sizeof(frame.key)};
+            memcpy(frame.key, BENCH_KEY, sizeof(frame.key));
+            if (write(requestWrite[requester], &frame, sizeof(frame)) != sizeof(frame)) perror("write");
+            WireResponse response;
+            if (!readFull(responseRead[requester], &response, sizeof(response)) || response.requestid != id) {
+                fprintf(stderr, "bench_ipc: bad response\n");
+                exit(1);
+            }
+        }
+};
+
+struct PointResult {
+    double roundTrips;      // per second
+    HistogramSnapshot latency;
+};
+
+// Forks the echo server, then runs `requesters` ping-pong threads against it.
+template <typename Transport>
+PointResult measure(int requesters, double seconds) {
+    Transport transport(requesters);
+    pid_t server = fork();
+    if (server == -1) {
+        perror("fork");
+        exit(1);
+    }
+    if (server == 0) {
+        transport.serve();
+        _exit(0);
+    }
+
+    std::vector<HistogramSnapshot> latencies(requesters);
+    std::vector<uint64_t> completed(requesters, 0);
+    uint64_t measureFrom = monotonicNs() + (uint64_t)(IPC_WARMUP_SECONDS * 1e9);
+    uint64_t measureTo = measureFrom + (uint64_t)(seconds * 1e9);
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < requesters; r++) {
+        threads.emplace_back([&, r]() {
+            // Counted locally and stored once: neighbouring entries of the
+            // shared vectors sit on the same cache lines.
+            HistogramSnapshot latency;
+            uint64_t count = 0;
+            uint64_t id = (uint64_t)r << 48;
+            while (true) {
+                uint64_t start = monotonicNs();
+                if (start >= measureTo) break;
+                transport.roundTrip(r, id++);
+                uint64_t end = monotonicNs();
+                if (start >= measureFrom && end <= measureTo) {
+                    latency.record(end - start);
+                    count++;
+                }
+            }
+            latencies[r] = latency;
+            completed[r] = count;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    kill(server, SIGKILL);
+    waitpid(server, nullptr, 0);
+
+    PointResult result;
+    uint64_t total = 0;
+    for (int r = 0; r < requesters; r++) {
+        result.latency.merge(latencies[r]);
+        total += completed[r];
+    }
+    result.roundTrips = total / seconds;
+    return result;
+}
+
+const char* transportNames[] = {"sem-slot", "ring-sem", "ring-futex", "ring-spin", "ring-eventfd", "pipe", "unix"};
+
+bool measureTransport(const std::string& name, int requesters, double seconds, PointResult& result) {
+    if (name == "sem-slot") result = measure<SemSlotTransport>(requesters, seconds);
+    else if (name == "ring-sem") result = measure<RingTransport<WAKE_SEM>>(requesters, seconds);
+    else if (name == "ring-futex") result = measure<RingTransport<WAKE_FUTEX>>(requesters, seconds);
+    else if (name == "ring-spin") result = measure<RingTransport<WAKE_SPIN>>(requesters, seconds);
+    else if (name == "ring-eventfd") result = measure<RingTransport<WAKE_EVENTFD>>(requesters, seconds);
+    else if (name == "pipe") result = measure<StreamTransport<false>>(requesters, seconds);
+    else if (name == "unix") result = measure<StreamTransport<true>>(requesters, seconds);
+    else return false;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    std::vector<std::string> transports(std::begin(transportNames), std::end(transportNames));
+    int maxRequesters = MAX_REQUESTERS;
+    double seconds = DEFAULT_IPC_SECONDS;
+    std::string jsonFile;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--transports" && i + 1 < argc) {
+            transports.clear();
+            std::stringstream list(argv[++i]);
+            std::string name;
+            while (std::getline(list, name, ',')) {
+                if (std::find(std::begin(transportNames), std::end(transportNames), name) == std::end(transportNames)) {
+                    std::cerr << "Unknown transport " << name << std::endl;
+                    return 1;
+                }
+                transports.push_back(name);
+            }
+        }
+        else if (arg == "--max-requesters" && i + 1 < argc) maxRequesters = std::max(1, std::min(std::stoi(argv[++i]), MAX_REQUESTERS));
+        else if (arg == "--duration" && i + 1 < argc) seconds = std::stod(argv[++i]);
+        else if (arg == "--json" && i + 1 < argc) jsonFile = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--transports a,b,..] [--max-requesters n] [--duration s] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"ipc\",\n  \"cpus\": " << std::thread::hardware_concurrency()
+         << ",\n  \"seconds\": " << seconds << ",\n  \"results\": [";
+    bool first = true;
+    printf("Round trips with no table work (%.1f s per point, %u cpus, latency in us)\n",
+           seconds, std::thread::hardware_concurrency());
+    for (const std::string& name : transports) {
+        printf("\n%-12s %10s %12s %9s %9s %9s %9s %9s %9s\n",
+               name.c_str(), "requesters", "round trips/s", "mean", "p50", "p90", "p99", "p99.9", "max");
+        double peak = 0;
+        int peakRequesters = 0;
+        for (int requesters = 1; requesters <= maxRequesters; requesters *= 2) {
+            PointResult result;
+            measureTransport(name, requesters, seconds, result);
+            const HistogramSnapshot& h = result.latency;
+            printf("%-12s %10d %12.0f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", "", requesters, result.roundTrips,
+                   h.mean() / 1000.0, h.percentile(0.5) / 1000.0, h.percentile(0.9) / 1000.0,
+                   h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0, h.max / 1000.0);
+            fflush(stdout);
+            if (result.roundTrips > peak) {
+                peak = result.roundTrips;
+                peakRequesters = requesters;
+            }
+            json << (first ? "\n" : ",\n") << "    {\"transport\": \"" << name << "\", \"requesters\": " << requesters
+                 << ", \"round_trips_per_sec\": " << (uint64_t)result.roundTrips
+                 << ", \"latency_ns\": {\"mean\": " << (uint64_t)h.mean() << ", \"p50\": " << h.percentile(0.5)
+                 << ", \"p90\": " << h.percentile(0.9) << ", \"p99\": " << h.percentile(0.99)
+                 << ", \"p99.9\": " << h.percentile(0.999) << ", \"max\": " << h.max << "}}";
+            first = false;
+        }
+        printf("%-12s peak %.0f round trips/s at %d requesters\n", "", peak, peakRequesters);
+    }
+    json << "\n  ]\n}\n";
+
+    if (!jsonFile.empty()) {
+        std::ofstream out(jsonFile);
+        out << json.str();
+        if (!out) {
+            perror(jsonFile.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <malloc.h>
+#include <unistd.h>
+#include "bench_engines.hpp"
+#include "workload.hpp"
+
+// Memory footprint of each engine per key. For every combination of engine,
+// bucket count and key count, an engine is filled with a workload.hpp key pool
+// (8 to 24 characters by default, so both short and heap-allocated strings).
+// Three numbers are then compared:
+//   - the engine's own footprint() estimate, broken down into bucket array,
+//     lock words, list nodes, string headers, long key storage and heap overhead
+//   - the heap it actually holds, counted by replacing operator new/delete:
+//     blocks, usable bytes and chunk bytes (usable plus glibc's header)
+//   - the growth in resident set size (/proc/self/statm)
+//
+//   ./bench_memory [--engines table,mutex-set,rwlock-set] [--buckets 1024,131072]
+//                  [--keys 10000,100000,1000000] [--key-len fixed:n|uniform:a-b|normal:m,s] [--json file]
+
+#define MALLOC_CHUNK_HEADER sizeof(size_t)
+
+// Live heap from operator new, updated by every allocation in the process.
+std::atomic<int64_t> heapBlocks(0);
+std::atomic<int64_t> heapUsable(0);
+
+void* countedNew(size_t size) {
+    void* block = malloc(size == 0 ? 1 : size);
+    if (block == nullptr) throw std::bad_alloc();
+    heapBlocks.fetch_add(1, std::memory_order_relaxed);
+    heapUsable.fetch_add(malloc_usable_size(block), std::memory_order_relaxed);
+    return block;
+}
+
+void countedDelete(void* block) {
+    if (block == nullptr) return;
+    heapBlocks.fetch_sub(1, std::memory_order_relaxed);
+    heapUsable.fetch_sub(malloc_usable_size(block), std::memory_order_relaxed);
+    free(block);
+}
+
+void* operator new(size_t size) { return countedNew(size); }
+void* operator new[](size_t size) { return countedNew(size); }
+void operator delete(void* block) noexcept { countedDelete(block); }
+void operator delete[](void* block) noexcept { countedDelete(block); }
+void operator delete(void* block, size_t) noexcept { countedDelete(block); }
+void operator delete[](void* block, size_t) noexcept { countedDelete(block); }
+
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+struct MemoryResult {
+    TableFootprint estimate;
+    int64_t blocks;
+    int64_t usable;
+    int64_t chunks;
+    int64_t resident;
+};
+
+template <typename Engine>
+MemoryResult measure(const Workload& workload, size_t buckets) {
+    malloc_trim(0);
+    int64_t blocksBefore = heapBlocks.load();
+    int64_t usableBefore = heapUsable.load();
+    int64_t residentBefore = residentBytes();
+
+    Engine* engine = new Engine(buckets, workload.poolSize());
+    Workload::Cursor cursor = workload.cursor();
+    while (cursor.loading()) engine->insert(cursor.next().key);
+
+    MemoryResult result;
+    result.blocks = heapBlocks.load() - blocksBefore;
+    result.usable = heapUsable.load() - usableBefore;
+    result.chunks = result.usable + result.blocks * MALLOC_CHUNK_HEADER;
+    result.resident = residentBytes() - residentBefore;
+    result.estimate = engine->footprint();
+    // The engine object itself is not part of its footprint.
+    result.blocks -= 1;
+    result.usable -= malloc_usable_size(engine);
+    result.chunks -= malloc_usable_size(engine) + MALLOC_CHUNK_HEADER;
+    delete engine;
+    return result;
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+int main(int argc, char* argv[]) {
+
+    std::vector<std::string> engines(std::begin(engineNames), std::end(engineNames));
+    std::vector<uint64_t> bucketCounts = {1024, 131072};
+    std::vector<uint64_t> keyCounts = {10000, 100000, 1000000};
+    WorkloadSpec spec;
+    spec.setLengths("uniform:8-24");
+    std::string jsonFile;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        bool valid = i + 1 < argc;
+        if (!valid) {}
+        else if (arg == "--engines") engines = splitList(argv[++i]);
+        else if (arg == "--buckets" || arg == "--keys") {
+            std::vector<uint64_t>& counts = arg == "--buckets" ? bucketCounts : keyCounts;
+            counts.clear();
+            for (const std::string& item : splitList(argv[++i])) counts.push_back(std::stoull(item));
+            valid = !counts.empty() && std::count(counts.begin(), counts.end(), 0) == 0;
+        }
+        else if (arg == "--key-len") valid = spec.setLengths(argv[++i]);
+        else if (arg == "--json") jsonFile = argv[++i];
+        else valid = false;
+        if (!valid) {
+            std::cerr << "Usage: " << argv[0] << " [--engines a,b] [--buckets n,..] [--keys n,..]"
+                      << " [--key-len fixed:n|uniform:min-max|normal:mean,stddev] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+    for (const std::string& engine : engines) {
+        if (std::find(std::begin(engineNames), std::end(engineNames), engine) == std::end(engineNames)) {
+            std::cerr << "Unknown engine " << engine << " (table, mutex-set, rwlock-set)" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"memory\",\n  \"key_lengths\": [" << spec.lengthA << ", " << spec.lengthB
+         << "],\n  \"results\": [";
+    bool first = true;
+    printf("Bytes per key (estimate from footprint(), heap from the counting allocator, rss from /proc)\n");
+    printf("%-10s %8s %8s | %7s %7s %7s %7s %7s %7s | %9s %9s %7s %9s\n", "engine", "buckets", "keys",
+           "buckets", "locks", "nodes", "strings", "keys", "heap+", "estimate", "heap", "blocks", "rss");
+    for (uint64_t keys : keyCounts) {
+        // Every engine keeps duplicates, so all `keys` pool keys are stored.
+        spec.poolSize = keys;
+        spec.load = true;
+        spec.seed = 1;
+        Workload workload(spec, 1);
+        for (uint64_t buckets : bucketCounts) {
+            for (const std::string& engine : engines) {
+                MemoryResult result;
+                withEngine(engine, [&]<typename Engine>() { result = measure<Engine>(workload, buckets); });
+                const TableFootprint& f = result.estimate;
+                double perKey = f.keys == 0 ? 0.0 : 1.0 / f.keys;
+                printf("%-10s %8lu %8lu | %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f | %9.1f %9.1f %7.2f %9.1f\n",
+                       engine.c_str(), (unsigned long)buckets, (unsigned long)f.keys,
+                       f.bucketArray * perKey, f.locks * perKey, f.listNodes * perKey, f.stringHeaders * perKey,
+                       f.keyBytes * perKey, f.heapOverhead * perKey, f.perKey(),
+                       result.chunks * perKey, result.blocks * perKey, result.resident * perKey);
+                fflush(stdout);
+
+                json << (first ? "\n" : ",\n") << "    {\"engine\": \"" << engine << "\", \"buckets\": " << buckets
+                     << ", \"keys\": " << f.keys << ", \"estimate\": {\"bucket_array\": " << f.bucketArray
+                     << ", \"locks\": " << f.locks << ", \"list_nodes\": " << f.listNodes
+                     << ", \"string_headers\": " << f.stringHeaders << ", \"key_bytes\": " << f.keyBytes
+                     << ", \"heap_overhead\": " << f.heapOverhead << ", \"total\": " << f.total()
+                     << "}, \"heap\": {\"blocks\": " << result.blocks << ", \"usable\": " << result.usable
+                     << ", \"chunks\": " << result.chunks << "}, \"rss\": " << result.resident << "}";
+                first = false;
+            }
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    if (!jsonFile.empty()) {
+        std::ofstream out(jsonFile);
+        out << json.str();
+        if (!out) {
+            perror(jsonFile.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
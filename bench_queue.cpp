@@ -0,0 +1,123 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include <queue>
+#include <semaphore.h>
+#include "workqueue.hpp"
+
+// Stage hand-off benchmark: the server's former semaphore-guarded std::queue
+// against the lock-free WorkQueue, for the same ingress -> N workers -> egress
+// shape the server uses.
+//
+//   ./bench_queue [items] [max_workers]
+
+#define DEFAULT_ITEMS 1000000
+#define DEFAULT_MAX_WORKERS 32
+#define BENCH_QUEUE_DEPTH 65536
+
+struct Item {
+    uint32_t channel;
+    uint32_t index;
+};
+
+// The queue server.cpp used before: binary semaphore lock + counting semaphore.
+template <typename T>
+class SemaphoreQueue {
+
+    private:
+
+        std::queue<T> items;
+        sem_t size;
+        sem_t lock;
+
+    public:
+
+        SemaphoreQueue() {
+            sem_init(&size, 0, 0);
+            sem_init(&lock, 0, 1);
+        }
+
+        void push(const T& item) {
+            sem_wait(&lock);
+            items.push(item);
+            sem_post(&lock);
+            sem_post(&size);
+        }
+
+        T pop() {
+            sem_wait(&size);
+            sem_wait(&lock);
+            T item = items.front();
+            items.pop();
+            sem_post(&lock);
+            return item;
+        }
+};
+
+// One item bounced between two threads; returns ns per one-way hand-off.
+template <typename Queue>
+double pingPong(uint64_t rounds) {
+    static Queue ping;
+    static Queue pong;
+
+    std::thread echo([&]() {
+        for (uint64_t i = 0; i < rounds; i++) pong.push(ping.pop());
+    });
+    uint64_t start = monotonicNs();
+    for (uint64_t i = 0; i < rounds; i++) {
+        ping.push({0, (uint32_t)i});
+        pong.pop();
+    }
+    uint64_t elapsed = monotonicNs() - start;
+    echo.join();
+    return (double)elapsed / (2.0 * rounds);
+}
+
+// ingress -> requests -> `workers` threads -> responses -> egress; returns Mops/s.
+template <typename Queue>
+double pipeline(uint64_t items, int workers) {
+    static Queue requests;
+    static Queue responses;
+
+    std::vector<std::thread> threads;
+    uint64_t start = monotonicNs();
+    for (int w = 0; w < workers; w++) {
+        uint64_t share = items / workers + (w < (int)(items % workers) ? 1 : 0);
+        threads.emplace_back([&, share]() {
+            for (uint64_t i = 0; i < share; i++) responses.push(requests.pop());
+        });
+    }
+    threads.emplace_back([&]() {
+        for (uint64_t i = 0; i < items; i++) responses.pop();
+    });
+    for (uint64_t i = 0; i < items; i++) requests.push({0, (uint32_t)i});
+    for (auto& thread : threads) thread.join();
+    uint64_t elapsed = monotonicNs() - start;
+    return (double)items * 1000.0 / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+
+    uint64_t items = argc > 1 ? std::stoull(argv[1]) : DEFAULT_ITEMS;
+    int maxWorkers = argc > 2 ? std::stoi(argv[2]) : DEFAULT_MAX_WORKERS;
+
+    using Semaphore = SemaphoreQueue<Item>;
+    using Ring = WorkQueue<Item, BENCH_QUEUE_DEPTH>;
+
+    uint64_t rounds = items / 10;
+    printf("Hand-off latency (ns, one way, %lu round trips)\n", (unsigned long)rounds);
+    printf("semaphore: %.1f   ring: %.1f\n\n", pingPong<Semaphore>(rounds), pingPong<Ring>(rounds));
+
+    printf("Pipeline throughput (Mops/s, %lu items, %u cpus)\n", (unsigned long)items, std::thread::hardware_concurrency());
+    printf("%8s %12s %12s\n", "workers", "semaphore", "ring");
+    for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+        double semaphore = pipeline<Semaphore>(items, workers);
+        double ring = pipeline<Ring>(items, workers);
+        printf("%8d %12.3f %12.3f\n", workers, semaphore, ring);
+    }
+
+    return 0;
+}
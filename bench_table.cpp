@@ -0,0 +1,224 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "bench_engines.hpp"
+#include "histogram.hpp"
+#include "workload.hpp"
+
+// HashTable benchmark without the IPC path: N threads drive a table directly
+// with a workload.hpp mix, for every combination of the swept parameters, and
+// the results come out as JSON. The engines (bench_engines.hpp) include
+// global-lock std::unordered_multiset baselines.
+//
+//   ./bench_table [--engines table,mutex-set,rwlock-set] [--buckets 1024,131072]
+//                 [--keys 100000] [--threads 1,2,4,8] [--ops n] [--mix ..]...
+//                 [--ycsb A-F]... [--skew uniform|zipfian[:theta]|..]... [--out file]
+//
+// Numeric flags take comma-separated lists. --mix, --ycsb and --skew take one
+// value each and may be repeated. Each thread first inserts its share of the
+// keys, untimed, then runs ops/threads operations.
+
+#define DEFAULT_BENCH_OPS 1000000
+#define LATENCY_SAMPLE_EVERY 8      // timing every operation would cost as much as a READ
+
+struct RunResult {
+    double seconds;
+    uint64_t ops;
+    HistogramSnapshot latency;
+};
+
+template <typename Engine>
+inline void apply(Engine& engine, const WorkloadOp& op) {
+    if (op.operation == INSERT) engine.insert(op.key);
+    else if (op.operation == READ) engine.read(op.key);
+    else engine.remove(op.key);
+}
+
+template <typename Engine>
+RunResult run(const Workload& workload, size_t buckets, int numThreads, uint64_t ops) {
+    Engine engine(buckets, workload.poolSize());
+    std::vector<HistogramSnapshot> latencies(numThreads);
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    uint64_t share = ops / numThreads;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            Workload::Cursor cursor = workload.cursor(t, numThreads);
+            while (cursor.loading()) apply(engine, cursor.next());
+            HistogramSnapshot& latency = latencies[t];
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (uint64_t i = 0; i < share; i++) {
+                WorkloadOp op = cursor.next();
+                if (i % LATENCY_SAMPLE_EVERY != 0) {
+                    apply(engine, op);
+                    continue;
+                }
+                uint64_t start = monotonicNs();
+                apply(engine, op);
+                latency.record(monotonicNs() - start);
+            }
+        });
+    }
+    while (ready.load() != numThreads) std::this_thread::yield();
+    uint64_t start = monotonicNs();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) thread.join();
+    RunResult result;
+    result.seconds = (monotonicNs() - start) / 1e9;
+    result.ops = share * numThreads;
+    for (const HistogramSnapshot& latency : latencies) result.latency.merge(latency);
+    return result;
+}
+
+const char* distributionNames[] = {"uniform", "zipfian", "hotspot", "latest"};    // by KeyDistribution
+
+bool runEngine(const std::string& name, const Workload& workload, size_t buckets, int numThreads, uint64_t ops, RunResult& result) {
+    return withEngine(name, [&]<typename Engine>() { result = run<Engine>(workload, buckets, numThreads, ops); });
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+std::vector<uint64_t> numberList(const std::string& text) {
+    std::vector<uint64_t> numbers;
+    for (const std::string& item : splitList(text)) numbers.push_back(std::stoull(item));
+    return numbers;
+}
+
+std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+int main(int argc, char* argv[]) {
+
+    std::vector<std::string> engines(std::begin(engineNames), std::end(engineNames));
+    std::vector<uint64_t> bucketCounts = {1024, 131072};
+    std::vector<uint64_t> keyCounts = {DEFAULT_KEY_POOL};
+    std::vector<uint64_t> threadCounts = {1, 2, 4, 8};
+    std::vector<std::string> mixes;
+    std::vector<std::string> skews;
+    uint64_t ops = DEFAULT_BENCH_OPS;
+    uint64_t seed = 1;
+    std::string outFile;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        std::string value(argv[++i]);
+        WorkloadSpec check;
+        bool valid = true;
+        if (arg == "--engines") engines = splitList(value);
+        else if (arg == "--buckets") bucketCounts = numberList(value);
+        else if (arg == "--keys") keyCounts = numberList(value);
+        else if (arg == "--threads") threadCounts = numberList(value);
+        else if (arg == "--ops") ops = std::stoull(value);
+        else if (arg == "--seed") seed = std::stoull(value);
+        else if (arg == "--out") outFile = value;
+        else if (arg == "--mix") valid = check.setMix(value), mixes.push_back(value);
+        else if (arg == "--ycsb") valid = check.setYcsb(value), mixes.push_back("ycsb:" + value);
+        else if (arg == "--skew") valid = check.setKeys(value), skews.push_back(value);
+        else valid = false;
+        if (!valid) {
+            std::cerr << "Invalid " << arg << " " << value << std::endl;
+            return 1;
+        }
+    }
+    if (std::count(bucketCounts.begin(), bucketCounts.end(), 0) != 0 || std::count(threadCounts.begin(), threadCounts.end(), 0) != 0) {
+        std::cerr << "--buckets and --threads must be positive" << std::endl;
+        return 1;
+    }
+    if (mixes.empty()) mixes = {"read=90,insert=5,delete=5"};
+    for (const std::string& engine : engines) {
+        if (std::find(std::begin(engineNames), std::end(engineNames), engine) == std::end(engineNames)) {
+            std::cerr << "Unknown engine " << engine << " (table, mutex-set, rwlock-set)" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"table\",\n  \"cpus\": " << std::thread::hardware_concurrency()
+         << ",\n  \"latency_sample_every\": " << LATENCY_SAMPLE_EVERY << ",\n  \"results\": [";
+    bool first = true;
+    for (uint64_t keys : keyCounts) {
+        for (const std::string& mix : mixes) {
+            // A YCSB mix brings its own key distribution unless --skew is given;
+            // other mixes run uniform and zipfian by default.
+            bool ycsb = mix.rfind("ycsb:", 0) == 0;
+            std::vector<std::string> mixSkews = skews;
+            if (mixSkews.empty()) mixSkews = ycsb ? std::vector<std::string>{""} : std::vector<std::string>{"uniform", "zipfian"};
+            for (std::string skew : mixSkews) {
+                WorkloadSpec spec;
+                if (ycsb) spec.setYcsb(mix.substr(5));
+                else spec.setMix(mix);
+                if (skew.empty()) skew = distributionNames[spec.keys];
+                else spec.setKeys(skew);
+                spec.poolSize = keys;
+                spec.load = true;
+                spec.seed = seed;
+                Workload workload(spec);
+
+                for (uint64_t buckets : bucketCounts) {
+                    for (const std::string& engine : engines) {
+                        for (uint64_t numThreads : threadCounts) {
+                            RunResult result;
+                            runEngine(engine, workload, buckets, numThreads, ops, result);
+                            double rate = result.ops / result.seconds;
+                            fprintf(stderr, "%-10s buckets=%-8lu keys=%-8lu threads=%-3lu %-26s %-12s %12.0f ops/s  p99 %lu ns\n",
+                                    engine.c_str(), (unsigned long)buckets, (unsigned long)keys, (unsigned long)numThreads,
+                                    mix.c_str(), skew.c_str(), rate, (unsigned long)result.latency.percentile(0.99));
+
+                            json << (first ? "\n" : ",\n") << "    {\"engine\": " << jsonString(engine)
+                                 << ", \"buckets\": " << buckets << ", \"keys\": " << keys
+                                 << ", \"mix\": " << jsonString(mix) << ", \"skew\": " << jsonString(skew)
+                                 << ", \"threads\": " << numThreads << ", \"ops\": " << result.ops
+                                 << ", \"seconds\": " << result.seconds << ", \"ops_per_sec\": " << (uint64_t)rate
+                                 << ", \"latency_ns\": {\"mean\": " << (uint64_t)result.latency.mean()
+                                 << ", \"p50\": " << result.latency.percentile(0.5)
+                                 << ", \"p90\": " << result.latency.percentile(0.9)
+                                 << ", \"p99\": " << result.latency.percentile(0.99)
+                                 << ", \"p99.9\": " << result.latency.percentile(0.999)
+                                 << ", \"max\": " << result.latency.max << "}}";
+                            first = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    if (outFile.empty()) std::cout << json.str();
+    else {
+        std::ofstream out(outFile);
+        out << json.str();
+        if (!out) {
+            perror(outFile.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "datatypes.hpp"
+
+// Binary capture of the requests a server takes in, replayed by the client
+// (workload.hpp). The file is a CaptureHeader followed by variable-length
+// records: a CaptureRecord and then `length` key bytes, with no padding.
+//
+// The server maps the file and every ingress thread reserves its record with
+// one fetch_add on CaptureHeader::used, so capturing takes no lock and no
+// syscall. A record's `operation` byte is written last: 0 means a record that
+// was reserved but never finished, and readers stop there.
+
+#define CAPTURE_MAGIC "KVCAPT01"
+#define DEFAULT_CAPTURE_MB 256
+
+struct CaptureHeader {
+    char magic[8];
+    uint64_t startNs;                   // CLOCK_MONOTONIC when the capture started
+    std::atomic<uint64_t> used;         // record bytes reserved, may pass the capacity
+    std::atomic<uint64_t> dropped;      // requests that did not fit
+};
+
+struct __attribute__((packed)) CaptureRecord {
+    uint64_t timeNs;        // since CaptureHeader::startNs
+    uint8_t length;
+    uint8_t operation;      // OperationType + 1
+};
+
+class CaptureWriter {
+
+    private:
+
+        int fd = -1;
+        CaptureHeader* header = nullptr;
+        char* records = nullptr;
+        uint64_t capacity = 0;
+        std::atomic<bool> stopped{false};
+        std::atomic<uint32_t> writers{0};
+
+    public:
+
+        bool open(const char* path, uint64_t bytes) {
+            fd = ::open(path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+            if (fd == -1 || ftruncate(fd, sizeof(CaptureHeader) + bytes) == -1) return false;
+            void* mapping = mmap(NULL, sizeof(CaptureHeader) + bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) return false;
+            header = (CaptureHeader*)mapping;
+            records = (char*)mapping + sizeof(CaptureHeader);
+            capacity = bytes;
+            header->startNs = monotonicNs();
+            header->used.store(0);
+            header->dropped.store(0);
+            memcpy(header->magic, CAPTURE_MAGIC, sizeof(header->magic));
+            return true;
+        }
+
+        // Safe from any number of threads. Operations other than INSERT, READ
+        // and DELETE (socket frames are not validated) are not captured: the
+        // reader would take them for the end of the capture.
+        void append(OperationType operation, std::string_view key, uint64_t now) {
+            if (operation != INSERT && operation != READ && operation != DELETE) return;
+            writers.fetch_add(1);
+            if (stopped.load()) {
+                writers.fetch_sub(1);
+                return;
+            }
+            uint64_t size = sizeof(CaptureRecord) + key.size();
+            uint64_t offset = header->used.fetch_add(size, std::memory_order_relaxed);
+            if (offset + size > capacity) {
+                header->dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            else {
+                CaptureRecord* record = (CaptureRecord*)(records + offset);
+                record->timeNs = now - header->startNs;
+                record->length = key.size();
+                memcpy(records + offset + sizeof(CaptureRecord), key.data(), key.size());
+                __atomic_store_n(&record->operation, (uint8_t)(operation + 1), __ATOMIC_RELEASE);
+            }
+            writers.fetch_sub(1);
+        }
+
+        // Stops further appends, waits out the ones in progress and trims the
+        // file to what was written. Returns the number of requests dropped.
+        uint64_t close() {
+            if (header == nullptr) return 0;
+            stopped.store(true);
+            while (writers.load() != 0) cpuRelax();
+            uint64_t used = std::min(header->used.load(), capacity);
+            uint64_t dropped = header->dropped.load();
+            header->used.store(used);
+            munmap(header, sizeof(CaptureHeader) + capacity);
+            header = nullptr;
+            ftruncate(fd, sizeof(CaptureHeader) + used);
+            ::close(fd);
+            return dropped;
+        }
+};
+
+// Read-only view of a capture file, indexed once so records can be taken
+// by position. Keys are string_views into the mapping.
+class CaptureReader {
+
+    private:
+
+        const char* mapping = nullptr;
+        size_t mappedBytes = 0;
+        std::vector<uint64_t> offsets;      // record offsets from the start of the file
+
+    public:
+
+        struct Entry {
+            OperationType operation;
+            std::string_view key;
+            uint64_t timeNs;
+        };
+
+        CaptureReader() = default;
+        CaptureReader(const CaptureReader&) = delete;
+        CaptureReader& operator=(const CaptureReader&) = delete;
+
+        ~CaptureReader() {
+            if (mapping != nullptr) munmap((void*)mapping, mappedBytes);
+        }
+
+        bool open(const char* path) {
+            int fd = ::open(path, O_RDONLY);
+            if (fd == -1) return false;
+            struct stat info;
+            if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(CaptureHeader)) {
+                ::close(fd);
+                return false;
+            }
+            mappedBytes = info.st_size;
+            void* mapped = mmap(NULL, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (mapped == MAP_FAILED) return false;
+            mapping = (const char*)mapped;
+            const CaptureHeader* header = (const CaptureHeader*)mapping;
+            if (memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) != 0) return false;
+
+            uint64_t end = sizeof(CaptureHeader) + std::min<uint64_t>(header->used.load(), mappedBytes - sizeof(CaptureHeader));
+            for (uint64_t offset = sizeof(CaptureHeader); offset + sizeof(CaptureRecord) <= end;) {
+                const CaptureRecord* record = (const CaptureRecord*)(mapping + offset);
+                if (record->operation == 0 || record->operation > DELETE + 1) break;
+                if (offset + sizeof(CaptureRecord) + record->length > end) break;
+                offsets.push_back(offset);
+                offset += sizeof(CaptureRecord) + record->length;
+            }
+            return true;
+        }
+
+        size_t size() const { return offsets.size(); }
+
+        Entry at(size_t index) const {
+            const CaptureRecord* record = (const CaptureRecord*)(mapping + offsets[index]);
+            return {(OperationType)(record->operation - 1),
+                    std::string_view(mapping + offsets[index] + sizeof(CaptureRecord), record->length),
+                    record->timeNs};
+        }
+
+        uint64_t dropped() const { return ((const CaptureHeader*)mapping)->dropped.load(); }
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <semaphore.h>
+#include "datatypes.hpp"
+#include "futex.hpp"
+#include "spin.hpp"
+
+#define SHM_CONTROL_NAME "/shared_memory_control"
+#define SHM_CHANNEL_PREFIX "/shared_memory_channel_"
+
+// Client side of the registry: registers this process in the control segment
+// and maps the dedicated Channel the server creates for it.
+class ClientChannel {
+
+    private:
+
+        ControlMemory* control = nullptr;
+        Channel* channel = nullptr;
+        int entry = -1;
+        bool attached = false;
+
+    public:
+
+        ClientChannel() {}
+        ClientChannel(const ClientChannel&) = delete;
+        ClientChannel& operator=(const ClientChannel&) = delete;
+        ~ClientChannel() { disconnect(); }
+
+        bool connect() {
+            int control_fd = shm_open(SHM_CONTROL_NAME, O_RDWR, 0666);
+            if (control_fd == -1) {
+                perror("shm_open");
+                return false;
+            }
+            void* control_ptr = mmap(NULL, sizeof(ControlMemory), PROT_READ | PROT_WRITE, MAP_SHARED, control_fd, 0);
+            close(control_fd);
+            if (control_ptr == MAP_FAILED) {
+                perror("mmap");
+                return false;
+            }
+            control = (ControlMemory*)control_ptr;
+
+            sem_wait(&control->registry_lock);
+            for (int i = 0; i < MAX_CLIENTS; ++i) {
+                if (control->clients[i].state.load() == CLIENT_FREE) {
+                    control->clients[i].pid = getpid();
+                    control->clients[i].state.store(CLIENT_REQUESTED);
+                    entry = i;
+                    break;
+                }
+            }
+            sem_post(&control->registry_lock);
+            if (entry == -1) {
+                fprintf(stderr, "connect: all %d client entries are in use\n", MAX_CLIENTS);
+                return false;
+            }
+
+            ClientEntry& client = control->clients[entry];
+            sem_post(&control->registry_request);
+            sem_wait(&client.ready);
+
+            int channel_fd = shm_open(client.channel_name, O_RDWR, 0666);
+            if (channel_fd == -1) {
+                perror("shm_open");
+                return false;
+            }
+            void* channel_ptr = mmap(NULL, sizeof(Channel), PROT_READ | PROT_WRITE, MAP_SHARED, channel_fd, 0);
+            close(channel_fd);
+            if (channel_ptr == MAP_FAILED) {
+                perror("mmap");
+                return false;
+            }
+            channel = (Channel*)channel_ptr;
+            return true;
+        }
+
+        // In-process use (tests): the caller owns both segments and plays the
+        // server; disconnect() leaves them alone.
+        void attach(ControlMemory& controlMemory, Channel& dedicated) {
+            control = &controlMemory;
+            channel = &dedicated;
+            attached = true;
+        }
+
+        // Every request must have completed before the channel is handed back.
+        void disconnect() {
+            if (attached) {
+                control = nullptr;
+                channel = nullptr;
+                attached = false;
+                return;
+            }
+            if (channel != nullptr) {
+                munmap(channel, sizeof(Channel));
+                channel = nullptr;
+            }
+            if (entry != -1) {
+                control->clients[entry].state.store(CLIENT_CLOSING);
+                sem_post(&control->registry_request);
+                entry = -1;
+            }
+            if (control != nullptr) {
+                munmap(control, sizeof(ControlMemory));
+                control = nullptr;
+            }
+        }
+
+        Channel& get() { return *channel; }
+
+        // Publishes a filled slot and wakes the ingress thread if it is parked.
+        void submit(uint32_t index) {
+            channel->slots[index].request.times.markSent();
+            channel->submitted.push(index);
+            control->doorbell.ring();
+        }
+
+        // Busy-poll wait for a NOTIFY_POLL slot: spin on Slot::state for up to
+        // spinNs, then park on the same word until the server flips it.
+        void waitPolled(uint32_t index, uint64_t spinNs) {
+            std::atomic<uint32_t>& state = channel->slots[index].state;
+            uint64_t deadline = monotonicNs() + spinNs;
+            for (uint32_t i = 1; state.load(std::memory_order_acquire) != SLOT_DONE; ++i) {
+                cpuRelax();
+                if ((i & 63) == 0 && monotonicNs() >= deadline) break;
+            }
+            while (true) {
+                uint32_t expected = SLOT_PENDING;
+                if (!state.compare_exchange_strong(expected, SLOT_PARKED)) {
+                    if (expected == SLOT_DONE) return;
+                }
+                futexWait(&state, SLOT_PARKED);
+            }
+        }
+};
+
+#endif
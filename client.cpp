@@ -5,74 +5,115 @@
 #include <thread>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/prctl.h>
 #include "hash.cpp"
 #include "datatypes.hpp"
 #include <semaphore.h>
 #include <csignal>
 #include <fcntl.h> 
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
 #include <atomic>
+#include "kvclient.hpp"
+#include "kvcoro.hpp"
+#include "log.hpp"
+#include "trace.hpp"
+#include "workload.hpp"
+#include "histogram.hpp"
 
 #define SHM_REQUEST_NAME "/shared_memory_request"
 #define NUM_CLIENT_THREADS 1
 
-#define MAX_STRING_LEN 6
+#define PIPELINE_DEPTH 128
+#define NUM_CORO_SESSIONS 1024
+#define DEFAULT_IDLE_US 100
+#define TRACE_SAMPLE_EVERY 1000
+#define DEFAULT_RUN_SECONDS 5
+#define OPEN_LOOP_WARMUP_MS 200
+#define DEFAULT_SLO_US 1000
+#define OPEN_LOOP_SPIN_NS 5000      // spin instead of sleeping when the next send is this close
 
 SharedMemory* sharedMemoryPtr = nullptr;
+ClientChannel* connectionPtr = nullptr;
+int numClientThreads = NUM_CLIENT_THREADS;
+uint64_t idleSpinNs = DEFAULT_IDLE_US * 1000;
+std::string socketUnixPath;
+int socketTcpPort = 0;
 std::vector<std::thread> threads;
 std::atomic<bool> running(true);
+std::string traceFile;
+Workload* workload = nullptr;
+
+// Open-loop schedule: each rate runs for runSeconds; a sweep steps from
+// rateFrom to rateTo and stops at the first rate whose p99 exceeds the SLO.
+double rateFrom = 0, rateTo = 0, rateStep = 0;
+bool poissonArrivals = true;
+double runSeconds = DEFAULT_RUN_SECONDS;
+double sloUs = DEFAULT_SLO_US;
 sem_t threads_safe_exit;
 
 void cleanup(int sig) {
 
     running = false;
-    for (int i = 0; i < NUM_CLIENT_THREADS; i++) 
+    for (int i = 0; i < numClientThreads; i++) 
         sem_wait(&threads_safe_exit);
 
-    munmap(sharedMemoryPtr, sizeof(SharedMemory));
+    if (connectionPtr != nullptr) connectionPtr->disconnect();
+    if (sharedMemoryPtr != nullptr) munmap(sharedMemoryPtr, sizeof(SharedMemory));
+    if (!traceFile.empty()) {
+        size_t traced = Tracer::instance().exportJson(traceFile);
+        std::cout << "Trace of " << traced << " requests written to " << traceFile << std::endl;
+    }
+    logFlush();
     exit(0);
 }
 
 //TODO: Do we need req_buffer_lock and res_buffer_lock?
 
-void sendRequestwaitResponse() {
+void sendRequestwaitResponse(int clientIndex) {
 
+    // Request ids only need to be unique among the server's clients: a
+    // random start, then consecutive.
     std::random_device rd;
-    std::mt19937_64 generator(rd());
-    std::uniform_int_distribution<uint64_t> requestIdDist(1, UINT64_MAX);
-    std::uniform_int_distribution<uint8_t> requestStringLength(1, MAX_STRING_LEN);
-    std::uniform_int_distribution<int> opTypeDist(0, 2);
-    std::uniform_int_distribution<char> charDist('a', 'z');
+    uint64_t nextId = ((uint64_t)rd() << 32) | rd();
+    Workload::Cursor cursor = workload->cursor(clientIndex, numClientThreads);
 
     Request request;
 
     while(running) {
 
-        request.requestid = requestIdDist(generator);
-        request.operation = static_cast<OperationType>(opTypeDist(generator));
-        auto stringLength = requestStringLength(generator);
-        for (size_t i = 0; i < stringLength; i++){
-            request.value[i] = charDist(generator);
-        }
-        request.value[stringLength]='\0';
+        Tracer::instance().begin(request.times);
+        WorkloadOp op = cursor.next();
+        request.requestid = nextId++;
+        request.operation = op.operation;
+        memcpy(request.value, op.key.data(), op.key.size());
+        request.value[op.key.size()]='\0';
 
-        std::cout<<"Request Created\n";
+        LOG_DEBUG("Request Created\n");
 
         sem_wait(&sharedMemoryPtr->req_space_available);
         // sem_wait(&sharedMemoryPtr->req_buffer_lock);
+        request.times.markSent();
         sharedMemoryPtr->request=request;
         // sem_post(&sharedMemoryPtr->req_buffer_lock);
         sem_post(&sharedMemoryPtr->req_available);
 
-        std::cout<<"Request Sent\n";
+        LOG_DEBUG("Request Sent\n");
 
         while(true) {
             sem_wait(&sharedMemoryPtr->res_available);
             // sem_wait(&sharedMemoryPtr->res_buffer_lock);
-            if (sharedMemoryPtr->response.requestid == request.requestid) break;
+            if (sharedMemoryPtr->response.requestid == request.requestid) {
+                Tracer::instance().finish(request.requestid, request.operation, sharedMemoryPtr->response.times);
+                break;
+            }
             // sem_post(&sharedMemoryPtr->res_buffer_lock);
             sem_post(&sharedMemoryPtr->res_available);
         }
-        std::cout<<"Response Received\n";
+        LOG_DEBUG("Response Received\n");
         // sem_post(&sharedMemoryPtr->res_buffer_lock);
         sem_post(&sharedMemoryPtr->res_space_available);
     }
@@ -82,26 +123,498 @@ void sendRequestwaitResponse() {
 
 }
 
+// Zero-copy mode: the request is generated straight into a shm slot and the
+// server answers in the same slot, so neither side copies the request body.
+void sendSlotwaitResponse(int clientIndex) {
+
+    // Request ids only need to be unique among the server's clients: a
+    // random start, then consecutive.
+    std::random_device rd;
+    uint64_t nextId = ((uint64_t)rd() << 32) | rd();
+    Workload::Cursor cursor = workload->cursor(clientIndex, numClientThreads);
+
+    Channel& channel = connectionPtr->get();
+
+    while(running) {
+
+        sem_wait(&channel.free_available);
+        uint32_t index;
+        while (!channel.free_slots.pop(index)) {}
+        Request& request = channel.slots[index].request;
+        Tracer::instance().begin(request.times);
+
+        WorkloadOp op = cursor.next();
+        request.requestid = nextId++;
+        request.operation = op.operation;
+        memcpy(request.value, op.key.data(), op.key.size());
+        request.value[op.key.size()]='\0';
+        channel.slots[index].notify = NOTIFY_SLOT;
+
+        LOG_DEBUG("Request Created\n");
+
+        connectionPtr->submit(index);
+
+        LOG_DEBUG("Request Sent\n");
+
+        sem_wait(&channel.slots[index].done);
+        LOG_DEBUG("Response Received\n");
+        Tracer::instance().finish(request.requestid, request.operation, request.times);
+
+        channel.free_slots.push(index);
+        sem_post(&channel.free_available);
+    }
+
+    sem_post(&threads_safe_exit);
+    return;
+
+}
+
+// Busy-poll mode: like zero-copy, but no semaphore is touched. Free slots are
+// claimed straight off the ring and completion is awaited by spinning on
+// Slot::state, parking on it only after idleSpinNs without a response.
+void sendSlotwaitPolled(int clientIndex) {
+
+    // Request ids only need to be unique among the server's clients: a
+    // random start, then consecutive.
+    std::random_device rd;
+    uint64_t nextId = ((uint64_t)rd() << 32) | rd();
+    Workload::Cursor cursor = workload->cursor(clientIndex, numClientThreads);
+
+    Channel& channel = connectionPtr->get();
+
+    while(running) {
+
+        uint32_t index;
+        while (!channel.free_slots.pop(index)) cpuRelax();
+        Slot& slot = channel.slots[index];
+        Request& request = slot.request;
+        Tracer::instance().begin(request.times);
+
+        WorkloadOp op = cursor.next();
+        request.requestid = nextId++;
+        request.operation = op.operation;
+        memcpy(request.value, op.key.data(), op.key.size());
+        request.value[op.key.size()]='\0';
+        slot.notify = NOTIFY_POLL;
+        slot.state.store(SLOT_PENDING, std::memory_order_relaxed);
+
+        LOG_DEBUG("Request Created\n");
+
+        connectionPtr->submit(index);
+
+        LOG_DEBUG("Request Sent\n");
+
+        connectionPtr->waitPolled(index, idleSpinNs);
+        LOG_DEBUG("Response Received\n");
+        Tracer::instance().finish(request.requestid, request.operation, request.times);
+
+        channel.free_slots.push(index);
+    }
+
+    sem_post(&threads_safe_exit);
+    return;
+
+}
+
+// Async mode: a single thread keeps PIPELINE_DEPTH requests in flight through
+// KvClient instead of waiting for each response.
+void sendRequestsPipelined(int clientIndex) {
+
+    Workload::Cursor cursor = workload->cursor(clientIndex, numClientThreads);
+    ClientChannel connection;
+    if (!connection.connect()) exit(1);
+    KvClient client(connection);
+
+    while(running) {
+
+        while (running && client.outstanding() < PIPELINE_DEPTH) {
+            WorkloadOp op = cursor.next();
+
+            client.submit(op.operation, op.key, [](const Response&) {
+                LOG_DEBUG("Response Received\n");
+            });
+
+            LOG_DEBUG("Request Sent\n");
+        }
+
+        client.wait();
+    }
+    client.drain();
+    connection.disconnect();
+
+    sem_post(&threads_safe_exit);
+    return;
+
+}
+
+struct RateResult {
+    double achieved = 0;
+    HistogramSnapshot latency;      // from when the request was due
+    HistogramSnapshot service;      // from when it was actually sent
+};
+
+// Issues requests at `rate` per second for runSeconds, whether or not earlier
+// ones have completed. When no slot is free the request goes out late, but
+// its latency still counts from when it was due, so server stalls show up as
+// queueing delay instead of as missing samples (coordinated omission).
+// Requests due during the first OPEN_LOOP_WARMUP_MS are not recorded.
+void runAtRate(KvClient& client, Workload::Cursor& cursor, std::mt19937_64& generator, double rate, RateResult& result) {
+
+    double gapNs = 1e9 / rate;
+    std::exponential_distribution<double> poissonGap(1 / gapNs);
+    uint64_t start = monotonicNs();
+    uint64_t recordFrom = start + OPEN_LOOP_WARMUP_MS * 1000000ULL;
+    uint64_t end = recordFrom + (uint64_t)(runSeconds * 1e9);
+    uint64_t completed = 0;
+
+    double due = start;
+    while (running && (uint64_t)due < end) {
+        uint64_t now = monotonicNs();
+        bool blocked = false;
+        while ((uint64_t)due <= now) {
+            WorkloadOp op = cursor.next();
+            uint64_t intended = (uint64_t)due;
+            bool sent = client.trySubmit(op.operation, op.key, [&result, &completed, intended, recordFrom](const Response& response) {
+                if (intended < recordFrom) return;
+                uint64_t done = monotonicNs();
+                result.latency.record(done - intended);
+                result.service.record(done - response.times.sent);
+                completed++;
+            });
+            if (!sent) {
+                blocked = true;
+                break;
+            }
+            due += poissonArrivals ? poissonGap(generator) : gapNs;
+        }
+        // Every slot busy: wait for one. Otherwise sleep until the next
+        // request is due unless a response comes first.
+        now = monotonicNs();
+        if (blocked) client.wait();
+        else if ((uint64_t)due > now + OPEN_LOOP_SPIN_NS) client.waitFor((uint64_t)due - now - OPEN_LOOP_SPIN_NS);
+        else client.poll();
+    }
+    client.drain();
+    result.achieved = completed / ((monotonicNs() < end ? monotonicNs() : end) - recordFrom + 1.0) * 1e9;
+}
+
+// Open-loop mode: one thread drives a KvClient on the schedule above and
+// prints a latency row per rate.
+void sendRequestsOpenLoop(int clientIndex) {
+
+    Workload::Cursor cursor = workload->cursor(clientIndex, numClientThreads);
+    std::random_device rd;
+    std::mt19937_64 generator(((uint64_t)rd() << 32) | rd());
+    ClientChannel connection;
+    if (!connection.connect()) exit(1);
+    KvClient client(connection);
+    // Sleeps must end on time: a late send counts as latency.
+    prctl(PR_SET_TIMERSLACK, 1);
+
+    // The load phase, if any, runs closed-loop before the first rate.
+    while (running && cursor.loading()) {
+        WorkloadOp op = cursor.next();
+        while (!client.trySubmit(op.operation, op.key, nullptr)) client.wait();
+    }
+    client.drain();
+
+    printf("%10s %10s %9s %9s %9s %9s %9s %9s %11s\n", "rate/s", "achieved/s", "mean", "p50", "p90", "p99", "p99.9", "max", "service p99");
+    double best = 0;
+    for (double rate = rateFrom; running && rate <= rateTo; rate += rateStep) {
+        static RateResult result;
+        result = RateResult();
+        runAtRate(client, cursor, generator, rate, result);
+        const HistogramSnapshot& h = result.latency;
+        printf("%10.0f %10.0f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %11.2f\n", rate, result.achieved, h.mean() / 1000.0,
+               h.percentile(0.5) / 1000.0, h.percentile(0.9) / 1000.0, h.percentile(0.99) / 1000.0,
+               h.percentile(0.999) / 1000.0, h.max / 1000.0, result.service.percentile(0.99) / 1000.0);
+        fflush(stdout);
+        if (h.percentile(0.99) > sloUs * 1000 || h.total == 0) break;
+        best = rate;
+        if (rateStep <= 0) break;
+    }
+    if (rateStep > 0) {
+        if (best > 0) printf("Highest rate with p99 <= %.0f us: %.0f/s\n", sloUs, best);
+        else printf("No rate met p99 <= %.0f us\n", sloUs);
+    }
+    connection.disconnect();
+
+    sem_post(&threads_safe_exit);
+    return;
+
+}
+
+int connectSocket() {
+    int fd;
+    if (!socketUnixPath.empty()) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, socketUnixPath.c_str(), sizeof(address.sun_path) - 1);
+        if (fd == -1 || connect(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+            perror("connect");
+            exit(1);
+        }
+    }
+    else {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(socketTcpPort);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd == -1 || connect(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+            perror("connect");
+            exit(1);
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+// Socket mode: one thread keeps PIPELINE_DEPTH requests in flight over the
+// server's Unix or TCP frontend, writing each refill as a single batch.
+void sendRequestsSocket(int clientIndex) {
+
+    Workload::Cursor cursor = workload->cursor(clientIndex, numClientThreads);
+    int fd = connectSocket();
+    std::vector<char> out;
+    std::vector<char> in(sizeof(WireResponse) * PIPELINE_DEPTH);
+    size_t inUsed = 0;
+    uint64_t nextId = 1;
+    int outstanding = 0;
+
+    while(running || outstanding > 0) {
+
+        out.clear();
+        while (running && outstanding < PIPELINE_DEPTH) {
+            WorkloadOp op = cursor.next();
+            WireRequestHeader header;
+            header.requestid = nextId++;
+            header.operation = op.operation;
+            header.length = op.key.size();
+            const char* bytes = reinterpret_cast<const char*>(&header);
+            out.insert(out.end(), bytes, bytes + sizeof(header));
+            out.insert(out.end(), op.key.begin(), op.key.end());
+            outstanding++;
+            LOG_DEBUG("Request Sent\n");
+        }
+        for (size_t sent = 0; sent < out.size();) {
+            ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                perror("send");
+                exit(1);
+            }
+            sent += n;
+        }
+
+        ssize_t n = read(fd, in.data() + inUsed, in.size() - inUsed);
+        if (n <= 0) {
+            perror("read");
+            exit(1);
+        }
+        inUsed += n;
+        size_t frames = inUsed / sizeof(WireResponse);
+        for (size_t i = 0; i < frames; i++) {
+            LOG_DEBUG("Response Received\n");
+        }
+        outstanding -= frames;
+        memmove(in.data(), in.data() + frames * sizeof(WireResponse), inUsed - frames * sizeof(WireResponse));
+        inUsed -= frames * sizeof(WireResponse);
+    }
+    close(fd);
+
+    sem_post(&threads_safe_exit);
+    return;
+
+}
+
+// One logical client session; NUM_CORO_SESSIONS of them share one thread.
+KvTask clientSession(KvLoop& kv, int index) {
+
+    Workload::Cursor cursor = workload->cursor(index, NUM_CORO_SESSIONS);
+
+    while(running) {
+        WorkloadOp op = cursor.next();
+
+        LOG_DEBUG("Request Sent\n");
+
+        co_await kv.submit(op.operation, op.key);
+
+        LOG_DEBUG("Response Received\n");
+    }
+}
+
+void runCoroutineSessions() {
+
+    ClientChannel connection;
+    if (!connection.connect()) exit(1);
+    KvClient client(connection);
+    KvLoop loop(client);
+
+    for (int i = 0; i < NUM_CORO_SESSIONS; ++i) {
+        loop.spawn(clientSession(loop, i));
+    }
+    loop.run();
+    connection.disconnect();
+
+    sem_post(&threads_safe_exit);
+    return;
+
+}
+
 int main(int argc, char* argv[]) {
 
-    int shm_fd = shm_open(SHM_REQUEST_NAME, O_RDWR, 0666);
-    if (shm_fd == -1) {
-        perror("shm_open");
-        exit(1);
+    bool zeroCopy = false;
+    bool async = false;
+    bool coro = false;
+    bool busyPoll = false;
+    int pinBase = -1;
+    uint32_t traceSample = TRACE_SAMPLE_EVERY;
+    WorkloadSpec spec;
+    std::string replayFile;
+    double replaySpeed = 1;
+    int clientThreads = NUM_CLIENT_THREADS;
+    bool timed = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        bool valid = true;
+        if (arg == "--zero-copy") zeroCopy = true;
+        else if (arg == "--async") async = true;
+        else if (arg == "--coro") coro = true;
+        else if (arg == "--busy-poll") busyPoll = zeroCopy = true;
+        else if (arg == "--idle-us" && i + 1 < argc) idleSpinNs = std::stoull(argv[++i]) * 1000;
+        else if (arg == "--pin-base" && i + 1 < argc) pinBase = std::stoi(argv[++i]);
+        else if (arg == "--unix" && i + 1 < argc) socketUnixPath = argv[++i];
+        else if (arg == "--tcp" && i + 1 < argc) socketTcpPort = std::stoi(argv[++i]);
+        else if (arg == "--trace" && i + 1 < argc) traceFile = argv[++i];
+        else if (arg == "--trace-sample" && i + 1 < argc) traceSample = std::stoi(argv[++i]);
+        else if (arg == "--ycsb" && i + 1 < argc) valid = spec.setYcsb(argv[++i]);
+        else if (arg == "--mix" && i + 1 < argc) valid = spec.setMix(argv[++i]);
+        else if (arg == "--keys" && i + 1 < argc) valid = spec.setKeys(argv[++i]);
+        else if (arg == "--key-len" && i + 1 < argc) valid = spec.setLengths(argv[++i]);
+        else if (arg == "--key-pool" && i + 1 < argc) spec.poolSize = std::stoull(argv[++i]);
+        else if (arg == "--load") spec.load = true;
+        else if (arg == "--seed" && i + 1 < argc) spec.seed = std::stoull(argv[++i]);
+        else if (arg == "--rate" && i + 1 < argc) rateFrom = rateTo = std::stod(argv[++i]);
+        else if (arg == "--sweep" && i + 1 < argc) valid = sscanf(argv[++i], "%lf:%lf:%lf", &rateFrom, &rateTo, &rateStep) == 3 && rateStep > 0;
+        else if (arg == "--arrival" && i + 1 < argc) poissonArrivals = std::string(argv[++i]) != "fixed";
+        else if (arg == "--duration" && i + 1 < argc) runSeconds = std::stod(argv[++i]), timed = true;
+        else if (arg == "--threads" && i + 1 < argc) {
+            clientThreads = std::stoi(argv[++i]);
+            valid = clientThreads >= 1;
+        }
+        else if (arg == "--slo-us" && i + 1 < argc) sloUs = std::stod(argv[++i]);
+        else if (arg == "--replay" && i + 1 < argc) replayFile = argv[++i];
+        else if (arg == "--speed" && i + 1 < argc) {
+            std::string speed(argv[++i]);
+            replaySpeed = speed == "max" ? 0 : std::stod(speed);
+            valid = replaySpeed >= 0;
+        }
+        if (!valid) {
+            std::cerr << "Invalid " << arg << " " << argv[i] << "\n"
+                      << "Workload: [--ycsb A-F] [--mix read=w,insert=w,delete=w,update=w,rmw=w]"
+                      << " [--keys uniform|zipfian[:theta]|hotspot[:keys,ops]|latest[:theta]]"
+                      << " [--key-len fixed:n|uniform:min-max|normal:mean,stddev] [--key-pool n] [--load] [--seed n]"
+                      << " [--replay capture [--speed x|max]]" << std::endl;
+            return 1;
+        }
     }
+    bool socketMode = !socketUnixPath.empty() || socketTcpPort != 0;
+    bool openLoop = rateTo > 0;
+    // Keys and operations are generated here, before anything is timed.
+    CaptureReader capture;
+    if (replayFile.empty()) {
+        workload = new Workload(spec);
+    }
+    else {
+        if (!capture.open(replayFile.c_str())) {
+            std::cerr << "Cannot read capture " << replayFile << std::endl;
+            return 1;
+        }
+        if (capture.size() == 0) {
+            std::cerr << "Capture " << replayFile << " has no requests" << std::endl;
+            return 1;
+        }
+        std::cout << "Replaying " << capture.size() << " requests from " << replayFile;
+        if (capture.dropped() != 0) std::cout << " (" << capture.dropped() << " dropped while capturing)";
+        std::cout << std::endl;
+        // The open-loop schedule sets the pace itself.
+        if (openLoop) replaySpeed = 0;
+        workload = new Workload(capture, replaySpeed);
+        // Inherited by the request threads, so paced sends wake on time.
+        if (replaySpeed > 0) prctl(PR_SET_TIMERSLACK, 1);
+    }
+    if (!traceFile.empty()) Tracer::instance().setSampling(traceSample);
 
-    void* shm_ptr = mmap(NULL, sizeof(SharedMemory), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-    if (shm_ptr == MAP_FAILED) {
-        perror("mmap");
-        exit(1);
+    // Zero-copy clients register for their own channel instead of using the
+    // legacy single-slot segment.
+    if (socketMode) {
+        // Talks to the socket frontend only.
     }
+    else if (zeroCopy && !async && !coro && !openLoop) {
+        connectionPtr = new ClientChannel();
+        if (!connectionPtr->connect()) exit(1);
+    }
+    else if (!async && !coro && !openLoop) {
+        int shm_fd = shm_open(SHM_REQUEST_NAME, O_RDWR, 0666);
+        if (shm_fd == -1) {
+            perror("shm_open");
+            exit(1);
+        }
+
+        void* shm_ptr = mmap(NULL, sizeof(SharedMemory), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+        if (shm_ptr == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
 
-    sharedMemoryPtr = (SharedMemory*)shm_ptr;
+        sharedMemoryPtr = (SharedMemory*)shm_ptr;
+    }
     sem_init(&threads_safe_exit, 0, 0);
     signal(SIGINT, cleanup);
 
-    for (int i = 0; i < NUM_CLIENT_THREADS; ++i) { 
-        threads.emplace_back(&sendRequestwaitResponse);
+    // The request threads start with SIGINT blocked, so cleanup() always runs
+    // on the main thread and never waits for the thread it interrupted.
+    sigset_t interrupt;
+    sigemptyset(&interrupt);
+    sigaddset(&interrupt, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &interrupt, nullptr);
+
+    // Every thread has its own connection, except that the coroutine sessions
+    // and the open-loop schedule share one.
+    numClientThreads = (coro || openLoop) ? 1 : clientThreads;
+    for (int i = 0; i < numClientThreads; ++i) { 
+        if (socketMode)
+            threads.emplace_back(&sendRequestsSocket, i);
+        else if (openLoop)
+            threads.emplace_back(&sendRequestsOpenLoop, i);
+        else if (coro)
+            threads.emplace_back(&runCoroutineSessions);
+        else if (async)
+            threads.emplace_back(&sendRequestsPipelined, i);
+        else if (busyPoll)
+            threads.emplace_back(&sendSlotwaitPolled, i);
+        else if (zeroCopy)
+            threads.emplace_back(&sendSlotwaitResponse, i);
+        else
+            threads.emplace_back(&sendRequestwaitResponse, i);
+    }
+
+    pthread_sigmask(SIG_UNBLOCK, &interrupt, nullptr);
+
+    if (pinBase >= 0) {
+        int numCpus = std::thread::hardware_concurrency();
+        for (size_t i = 0; i < threads.size(); ++i) {
+            if (!pinThread(threads[i], (pinBase + i) % numCpus)) std::cerr << "pthread_setaffinity_np failed\n";
+        }
+    }
+
+    // A closed-loop run with --duration stops by itself; the threads finish
+    // the request they are waiting on.
+    if (timed && !openLoop) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(runSeconds));
+        running = false;
     }
 
     for (auto& thread : threads) {
@@ -109,6 +622,8 @@ int main(int argc, char* argv[]) {
             thread.join();
     }
 
+    // Only open-loop and --duration runs get here.
+    cleanup(0);
     return 0;
 
 }
\ No newline at end of file
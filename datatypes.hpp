@@ -2,6 +2,11 @@
 #define DATATYPES_H
 
 #include <semaphore.h>
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include "ring.hpp"
+#include "spin.hpp"
 
 enum OperationType {
     INSERT,
@@ -14,19 +19,120 @@ enum ReturnType {
     FAILURE
 };
 
+// CLOCK_MONOTONIC stamps (monotonicNs), comparable between the client and
+// server processes. The client sets `created` and `sent`, the server the
+// rest; the gaps feed the per-stage histograms (stats.hpp) and, for sampled
+// requests, the client's trace (trace.hpp). 0 means not stamped.
+struct StageTimes {
+    uint64_t created;       // client started building the request (sampled only)
+    uint64_t sent;          // client published the request
+    uint64_t ingress;       // server took it from shm
+    uint64_t dequeued;      // a worker took it off the stage queue
+    uint64_t op_start;      // hash table operation started
+    uint64_t executed;      // hash table operation finished
+    uint64_t egress;        // response published to the client
+    uint32_t sampled;       // traced: the server stamps it even with --no-stats
+
+    void markSent() {
+        sent = monotonicNs();
+        ingress = dequeued = op_start = executed = egress = 0;
+    }
+};
+
 struct Response {
     uint64_t requestid;
     ReturnType returntype;
     bool result;
+    StageTimes times;       // copied from the request, for the legacy egress
 };
 
 struct Request {
     uint64_t requestid;
     OperationType operation;
     char value[256];
+    StageTimes times;
 };
 
 #define FIFO_DEPTH 256
+#define MAX_CLIENTS 64
+
+enum NotifyType {
+    NOTIFY_SLOT,    // server posts Slot::done
+    NOTIFY_RING,    // server pushes the index on Channel::completed
+    NOTIFY_POLL     // server flips Slot::state, the client spins on it
+};
+
+enum SlotState : uint32_t {
+    SLOT_PENDING,
+    SLOT_PARKED,    // busy-poll client gave up spinning and sleeps on `state`
+    SLOT_DONE
+};
+
+// One request/response pair that lives in shm for the whole round trip. In
+// zero-copy mode the server works on `request` in place and the client owns
+// the slot again only after it has been notified.
+struct Slot {
+    Request request;
+    Response response;
+    NotifyType notify;
+    sem_t done;
+    std::atomic<uint32_t> state;
+};
+
+// Per-client channel used by zero-copy mode. Slot indices circulate between
+// the free ring (the client's credits), the submitted ring (owned by the
+// server) and, for pipelined clients, the completed ring.
+struct Channel {
+    BoundedRing<uint32_t, FIFO_DEPTH> free_slots;
+    BoundedRing<uint32_t, FIFO_DEPTH> submitted;
+    BoundedRing<uint32_t, FIFO_DEPTH> completed;
+    sem_t free_available;
+    // Rung once per egress batch, however many indices it pushed on `completed`.
+    alignas(64) Doorbell comp_bell;
+
+    Slot slots[FIFO_DEPTH];
+};
+
+enum ClientState : uint32_t {
+    CLIENT_FREE,
+    CLIENT_REQUESTED,   // client asked for a channel
+    CLIENT_ACTIVE,      // server created the channel
+    CLIENT_CLOSING      // client is gone, server may hand the entry out again
+};
+
+struct ClientEntry {
+    std::atomic<uint32_t> state;
+    pid_t pid;
+    char channel_name[32];
+    sem_t ready;
+};
+
+// Control segment shared by every zero-copy client. A client registers here
+// once and then talks to the server only through its own Channel segment.
+// Submissions ring `doorbell`, which the ingress thread parks on when every
+// channel is empty.
+struct ControlMemory {
+    sem_t registry_lock;
+    sem_t registry_request;
+    alignas(64) Doorbell doorbell;
+    alignas(64) ClientEntry clients[MAX_CLIENTS];
+};
+
+// Frames of the socket frontend protocol. Fields are in host byte order since
+// the frontend only listens on loopback and Unix sockets. A request header is
+// followed by `length` key bytes; requests may be pipelined freely and
+// responses come back tagged with the same requestid, not necessarily in order.
+struct __attribute__((packed)) WireRequestHeader {
+    uint64_t requestid;
+    uint8_t operation;
+    uint8_t length;
+};
+
+struct __attribute__((packed)) WireResponse {
+    uint64_t requestid;
+    uint8_t returntype;
+    uint8_t result;
+};
 
 struct SharedMemory {
     Request request;
@@ -0,0 +1,24 @@
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// Thin wrappers over the futex syscall for words that live in shm. The
+// non-private operations are used so waiters and wakers may be in different
+// processes.
+
+inline void futexWait(std::atomic<uint32_t>* word, uint32_t expected, const struct timespec* timeout = nullptr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+inline void futexWake(std::atomic<uint32_t>* word, int count = INT_MAX) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+
+#endif
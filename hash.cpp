@@ -4,11 +4,46 @@
 #include <mutex>
 #include <shared_mutex>
 #include <algorithm> 
+#include <string>
+#include <string_view>
 // #include <boost/thread/shared_mutex.hpp>  // Include Boost's shared_mutex
 // #include <boost/thread/locks.hpp>
 #include "datatypes.hpp"
+#include "probes.hpp"
 #include <functional>
 
+// What a table's memory goes to, in bytes. Node layouts are libstdc++'s and
+// heap overhead is glibc malloc's (chunk header and 16-byte rounding, or page
+// rounding for mmap'd blocks), so these are estimates; bench_memory checks
+// them against a counting allocator.
+struct TableFootprint {
+    size_t keys = 0;
+    size_t bucketArray = 0;     // bucket headers, without their locks
+    size_t locks = 0;
+    size_t listNodes = 0;       // node links
+    size_t stringHeaders = 0;   // std::string objects, short keys included
+    size_t keyBytes = 0;        // heap storage of keys too long for the string itself
+    size_t heapOverhead = 0;
+
+    size_t total() const { return bucketArray + locks + listNodes + stringHeaders + keyBytes + heapOverhead; }
+    double perKey() const { return keys == 0 ? 0.0 : (double)total() / keys; }
+};
+
+// Bytes glibc malloc takes for a `request`-byte allocation.
+inline size_t mallocChunk(size_t request) {
+    if (request >= 128 * 1024) return (request + 16 + 4095) & ~(size_t)4095;
+    return std::max<size_t>(32, (request + 8 + 15) & ~(size_t)15);
+}
+
+// Adds a heap block of `request` bytes to the overhead.
+inline void addBlock(TableFootprint& footprint, size_t request) {
+    footprint.heapOverhead += mallocChunk(request) - request;
+}
+
+inline bool onHeap(const std::string& text) {
+    return text.data() < (const char*)&text || text.data() >= (const char*)(&text + 1);
+}
+
 
 class HashTable {
 
@@ -28,8 +63,9 @@ class HashTable {
         //     return index % tableSize;
         // }
 
-        uint32_t hashFunction(std::string input) {
-            std::hash<std::string> hasher;
+        // string_view lets callers hash keys that live in shm without copying them
+        uint32_t hashFunction(std::string_view input) {
+            std::hash<std::string_view> hasher;
             uint64_t hashed_value = hasher(input);
             return (uint32_t)(hashed_value % tableSize);
         }
@@ -37,34 +73,107 @@ class HashTable {
 
     public:
 
+        // One operation of a batch; `result` is filled in by applyGroup().
+        struct KeyOp {
+            OperationType operation;
+            std::string_view key;
+            bool result;
+        };
+
         HashTable(int size): tableSize(size), table(size) {}
         ~HashTable(){};
 
-        void insert(const std::string& input_string) {
+        // table_op_start fires before the bucket lock is taken, so lock waits
+        // count towards the operation.
+        void insert(std::string_view input_string) {
+            KV_PROBE3(table_op_start, INSERT, input_string.data(), input_string.size());
             uint32_t index = hashFunction(input_string);
             std::unique_lock<std::shared_mutex> lock(table[index].lock);
             // boost::unique_lock<boost::shared_mutex> lock(table[index].lock);  
             table[index].items.emplace_back(input_string);
+            KV_PROBE2(table_op_end, INSERT, true);
         }
 
-        bool read(const std::string& input_string) {
+        bool read(std::string_view input_string) {
+            KV_PROBE3(table_op_start, READ, input_string.data(), input_string.size());
             uint32_t index = hashFunction(input_string);
             std::shared_lock<std::shared_mutex> lock(table[index].lock);
             // boost::shared_lock<boost::shared_mutex> lock(table[index].lock); 
+            bool found = false;
             for (const auto& item : table[index].items) {
                 if (item == input_string) {
-                    return true;
+                    found = true;
+                    break;
                 }
             }
-            return false;
+            KV_PROBE2(table_op_end, READ, found);
+            return found;
         }
 
-        void remove(const std::string& input_string) {
+        void remove(std::string_view input_string) {
+            KV_PROBE3(table_op_start, DELETE, input_string.data(), input_string.size());
             uint32_t index = hashFunction(input_string);
             std::unique_lock<std::shared_mutex> lock(table[index].lock);
             // boost::unique_lock<boost::shared_mutex> lock(table[index].lock); 
             auto iteration = std::find(table[index].items.begin(), table[index].items.end(), input_string);
             if (iteration != table[index].items.end()) {table[index].items.erase(iteration);};
+            KV_PROBE2(table_op_end, DELETE, true);
+        }
+
+        uint32_t bucketOf(std::string_view key) { return hashFunction(key); }
+
+        // Walks every bucket under its shared lock; safe while the table is in use.
+        TableFootprint footprint() {
+            const size_t node = 2 * sizeof(void*) + sizeof(std::string);
+            TableFootprint footprint;
+            footprint.bucketArray = table.size() * (sizeof(Bucket) - sizeof(std::shared_mutex));
+            footprint.locks = table.size() * sizeof(std::shared_mutex);
+            addBlock(footprint, table.size() * sizeof(Bucket));
+            for (Bucket& bucket : table) {
+                std::shared_lock<std::shared_mutex> lock(bucket.lock);
+                for (const std::string& item : bucket.items) {
+                    footprint.keys++;
+                    footprint.listNodes += 2 * sizeof(void*);
+                    footprint.stringHeaders += sizeof(std::string);
+                    addBlock(footprint, node);
+                    if (onHeap(item)) {
+                        footprint.keyBytes += item.capacity() + 1;
+                        addBlock(footprint, item.capacity() + 1);
+                    }
+                }
+            }
+            return footprint;
+        }
+
+        // Applies `count` operations that all hash to bucket `index`, in order,
+        // under a single acquisition of its lock: shared if they are all READs.
+        void applyGroup(uint32_t index, KeyOp* ops, size_t count) {
+            Bucket& bucket = table[index];
+            bool readOnly = std::all_of(ops, ops + count, [](const KeyOp& op) { return op.operation == READ; });
+            std::unique_lock<std::shared_mutex> writer(bucket.lock, std::defer_lock);
+            std::shared_lock<std::shared_mutex> reader(bucket.lock, std::defer_lock);
+            if (readOnly) reader.lock();
+            else writer.lock();
+
+            for (size_t i = 0; i < count; ++i) {
+                KeyOp& op = ops[i];
+                KV_PROBE3(table_op_start, op.operation, op.key.data(), op.key.size());
+                if (op.operation == INSERT) {
+                    bucket.items.emplace_back(op.key);
+                    op.result = true;
+                    KV_PROBE2(table_op_end, op.operation, op.result);
+                    continue;
+                }
+                auto found = std::find(bucket.items.begin(), bucket.items.end(), op.key);
+                if (op.operation == READ) {
+                    op.result = found != bucket.items.end();
+                }
+                else {
+                    if (found != bucket.items.end()) bucket.items.erase(found);
+                    op.result = true;
+                }
+                KV_PROBE2(table_op_end, op.operation, op.result);
+            }
         }
 
 };
\ No newline at end of file
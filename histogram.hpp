@@ -0,0 +1,114 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// HDR-style log-linear histogram of nanosecond values. Values below
+// 2^HIST_SUB_BITS are exact; above that every power of two is split into
+// 2^HIST_SUB_BITS buckets, so a bucket is within 1/16 (6.25%) of its values.
+// Values beyond 2^(HIST_MAX_EXP + 1) ns (about 36 minutes) share the last bucket.
+#define HIST_SUB_BITS 4
+#define HIST_MAX_EXP 40
+#define HIST_BUCKETS ((HIST_MAX_EXP - HIST_SUB_BITS + 2) << HIST_SUB_BITS)
+
+inline size_t histBucket(uint64_t value) {
+    if (value < (1ULL << HIST_SUB_BITS)) return value;
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > HIST_MAX_EXP) return HIST_BUCKETS - 1;
+    size_t sub = (value >> (exponent - HIST_SUB_BITS)) & ((1ULL << HIST_SUB_BITS) - 1);
+    return ((size_t)(exponent - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + sub;
+}
+
+// Smallest value that lands in `bucket`.
+inline uint64_t histBucketLow(size_t bucket) {
+    if (bucket < (1ULL << HIST_SUB_BITS)) return bucket;
+    int exponent = (bucket >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+    uint64_t sub = bucket & ((1ULL << HIST_SUB_BITS) - 1);
+    return ((1ULL << HIST_SUB_BITS) + sub) << (exponent - HIST_SUB_BITS);
+}
+
+inline uint64_t histBucketHigh(size_t bucket) {
+    return bucket + 1 < HIST_BUCKETS ? histBucketLow(bucket + 1) - 1 : UINT64_MAX;
+}
+
+// Single writer, any number of readers: the owning thread updates the counts
+// with plain relaxed stores (no locked instructions) and readers in this or
+// another process merge whatever they see. Holds only atomics, so it may be
+// placed in shm.
+struct Histogram {
+    std::atomic<uint64_t> counts[HIST_BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+
+    void record(uint64_t value) {
+        std::atomic<uint64_t>& count = counts[histBucket(value)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
+
+// Plain copy used to merge per-thread histograms and to diff two readings.
+struct HistogramSnapshot {
+    uint64_t counts[HIST_BUCKETS] = {};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    void merge(const Histogram& histogram) {
+        total += histogram.total.load(std::memory_order_acquire);
+        for (size_t i = 0; i < HIST_BUCKETS; ++i) counts[i] += histogram.counts[i].load(std::memory_order_relaxed);
+        sum += histogram.sum.load(std::memory_order_relaxed);
+        uint64_t seen = histogram.max.load(std::memory_order_relaxed);
+        if (seen > max) max = seen;
+    }
+
+    void merge(const HistogramSnapshot& other) {
+        total += other.total;
+        for (size_t i = 0; i < HIST_BUCKETS; ++i) counts[i] += other.counts[i];
+        sum += other.sum;
+        if (other.max > max) max = other.max;
+    }
+
+    void record(uint64_t value) {
+        counts[histBucket(value)]++;
+        total++;
+        sum += value;
+        if (value > max) max = value;
+    }
+
+    // What was recorded since `earlier` (max stays cumulative).
+    HistogramSnapshot since(const HistogramSnapshot& earlier) const {
+        HistogramSnapshot delta = *this;
+        delta.total = 0;
+        for (size_t i = 0; i < HIST_BUCKETS; ++i) {
+            delta.counts[i] = counts[i] >= earlier.counts[i] ? counts[i] - earlier.counts[i] : 0;
+            delta.total += delta.counts[i];
+        }
+        delta.sum = sum - earlier.sum;
+        return delta;
+    }
+
+    // Upper bound of the bucket holding the given quantile (0 < q <= 1).
+    uint64_t percentile(double quantile) const {
+        uint64_t seen = 0;
+        for (size_t i = 0; i < HIST_BUCKETS; ++i) seen += counts[i];
+        if (seen == 0) return 0;
+        uint64_t rank = (uint64_t)(quantile * seen + 0.5);
+        if (rank == 0) rank = 1;
+        uint64_t running = 0;
+        for (size_t i = 0; i < HIST_BUCKETS; ++i) {
+            running += counts[i];
+            if (running >= rank) return histBucketHigh(i) < max ? histBucketHigh(i) : max;
+        }
+        return max;
+    }
+
+    double mean() const { return total == 0 ? 0.0 : (double)sum / total; }
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef KVCLIENT_H
+#define KVCLIENT_H
+
+#include <cstring>
+#include <functional>
+#include <future>
+#include <string_view>
+#include <semaphore.h>
+#include "datatypes.hpp"
+#include "channel.hpp"
+#include "trace.hpp"
+
+// Pipelined client for a zero-copy Channel. Every operation claims its own
+// slot, so up to FIFO_DEPTH requests can be in flight from a single thread.
+// Completions come back on Channel::completed as slot indices, which index
+// straight into `pending` without any search.
+//
+// A KvClient is driven by one thread: callbacks run inside poll()/wait().
+// Completions on the completed ring go to whoever pops them, so each KvClient
+// needs a ClientChannel of its own.
+class KvClient {
+
+    public:
+
+        using Callback = std::function<void(const Response&)>;
+
+    private:
+
+        struct Pending {
+            uint64_t requestid;
+            Callback callback;
+        };
+
+        ClientChannel& connection;
+        Channel& channel;
+        Pending pending[FIFO_DEPTH];
+        uint64_t nextSequence = 1;
+        size_t inFlight = 0;
+
+        void claimSlot(uint32_t& index) {
+            while (sem_trywait(&channel.free_available) != 0) {
+                // Our own completions may be holding the slots we need.
+                if (inFlight > 0) {
+                    wait();
+                }
+                else {
+                    sem_wait(&channel.free_available);
+                    break;
+                }
+            }
+            while (!channel.free_slots.pop(index)) {}
+        }
+
+        void complete(uint32_t index) {
+            Slot& slot = channel.slots[index];
+            Pending& entry = pending[index];
+            Callback callback = std::move(entry.callback);
+            entry.callback = nullptr;
+            Response response = slot.response;
+            Tracer::instance().finish(slot.request.requestid, slot.request.operation, slot.request.times);
+
+            channel.free_slots.push(index);
+            sem_post(&channel.free_available);
+            inFlight--;
+
+            // Someone else's response in our slot: fail the request rather than
+            // leave its future or session waiting forever.
+            if (response.requestid != entry.requestid) response = Response{entry.requestid, FAILURE, false, {}};
+            if (callback) callback(response);
+        }
+
+        void publish(uint32_t index, OperationType operation, std::string_view key, Callback callback) {
+            Slot& slot = channel.slots[index];
+            Tracer::instance().begin(slot.request.times);
+            // The low bits carry the slot index so ids stay unique per channel.
+            uint64_t requestid = (nextSequence++ * FIFO_DEPTH) + index;
+            slot.request.requestid = requestid;
+            slot.request.operation = operation;
+            memcpy(slot.request.value, key.data(), key.size());
+            slot.request.value[key.size()] = '\0';
+            slot.notify = NOTIFY_RING;
+
+            pending[index].requestid = requestid;
+            pending[index].callback = std::move(callback);
+            inFlight++;
+
+            connection.submit(index);
+        }
+
+    public:
+
+        explicit KvClient(ClientChannel& connection): connection(connection), channel(connection.get()) {}
+        KvClient(const KvClient&) = delete;
+        KvClient& operator=(const KvClient&) = delete;
+
+        static bool fits(std::string_view key) { return key.size() < sizeof(Request::value); }
+
+        // Returns false if the key does not fit in Request::value.
+        bool submit(OperationType operation, std::string_view key, Callback callback) {
+            if (!fits(key)) return false;
+
+            uint32_t index;
+            claimSlot(index);
+            publish(index, operation, key, std::move(callback));
+            return true;
+        }
+
+        // Like submit(), but returns false instead of blocking when no slot is free.
+        bool trySubmit(OperationType operation, std::string_view key, Callback callback) {
+            if (!fits(key)) return false;
+            if (sem_trywait(&channel.free_available) != 0) return false;
+
+            uint32_t index;
+            while (!channel.free_slots.pop(index)) {}
+            publish(index, operation, key, std::move(callback));
+            return true;
+        }
+
+        std::future<Response> submit(OperationType operation, std::string_view key) {
+            auto promise = std::make_shared<std::promise<Response>>();
+            std::future<Response> future = promise->get_future();
+            if (!submit(operation, key, [promise](const Response& response) { promise->set_value(response); })) {
+                Response failure{0, FAILURE, false, {}};
+                promise->set_value(failure);
+            }
+            return future;
+        }
+
+        std::future<Response> insert(std::string_view key) { return submit(INSERT, key); }
+        std::future<Response> read(std::string_view key) { return submit(READ, key); }
+        std::future<Response> remove(std::string_view key) { return submit(DELETE, key); }
+
+        // Runs callbacks for every completion already published. Never blocks.
+        size_t poll() {
+            size_t completed = 0;
+            uint32_t index;
+            while (channel.completed.pop(index)) {
+                complete(index);
+                completed++;
+            }
+            return completed;
+        }
+
+        // Blocks until at least one completion has been handled.
+        size_t wait() {
+            if (inFlight == 0) return 0;
+            uint32_t index;
+            spinThenPark(channel.comp_bell, 0, [&]() { return channel.completed.pop(index); });
+            complete(index);
+            return 1 + poll();
+        }
+
+        // Like wait(), but gives up after timeoutNs. With nothing in flight
+        // it just sleeps that long.
+        size_t waitFor(uint64_t timeoutNs) {
+            size_t completed = poll();
+            if (completed != 0) return completed;
+            struct timespec timeout = {(time_t)(timeoutNs / 1000000000), (long)(timeoutNs % 1000000000)};
+            if (inFlight == 0) {
+                nanosleep(&timeout, nullptr);
+                return 0;
+            }
+            uint32_t seen = channel.comp_bell.prepareWait();
+            if (channel.completed.size() != 0) {
+                channel.comp_bell.cancelWait();
+                return poll();
+            }
+            channel.comp_bell.wait(seen, &timeout);
+            return poll();
+        }
+
+        // Drives completions until `future` is ready.
+        Response get(std::future<Response>& future) {
+            while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                wait();
+            }
+            return future.get();
+        }
+
+        void drain() {
+            while (inFlight > 0) wait();
+        }
+
+        size_t outstanding() const { return inFlight; }
+};
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef KVCORO_H
+#define KVCORO_H
+
+// Requires C++20 (-std=c++20).
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <string_view>
+#include <unordered_set>
+#include "kvclient.hpp"
+
+class KvLoop;
+
+// Top-level coroutine type for a client session, e.g.
+//
+//     KvTask session(KvLoop& kv) {
+//         Response response = co_await kv.read("abc");
+//     }
+//
+// Sessions start suspended and are resumed only by KvLoop::run(). A session
+// awaits KvLoop operations directly; awaiting another KvTask is not supported.
+class KvTask {
+
+    public:
+
+        struct promise_type {
+            std::exception_ptr exception;
+
+            KvTask get_return_object() { return KvTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        KvTask(KvTask&& other) noexcept: handle(other.handle) { other.handle = nullptr; }
+        KvTask(const KvTask&) = delete;
+        ~KvTask() { if (handle) handle.destroy(); }
+
+    private:
+
+        friend class KvLoop;
+
+        explicit KvTask(std::coroutine_handle<promise_type> handle): handle(handle) {}
+
+        std::coroutine_handle<promise_type> release() {
+            auto released = handle;
+            handle = nullptr;
+            return released;
+        }
+
+        std::coroutine_handle<promise_type> handle;
+};
+
+// Single-threaded event loop that multiplexes many KvTask sessions over one
+// KvClient. Completion callbacks only queue the waiting coroutine; run()
+// resumes it afterwards, so a session never runs inside KvClient::poll().
+// Operations that find every slot busy wait in `backlog` until one frees up.
+class KvLoop {
+
+    public:
+
+        class Operation {
+
+            private:
+
+                friend class KvLoop;
+
+                KvLoop& loop;
+                OperationType operation;
+                std::string_view key;
+                Response response{0, FAILURE, false, {}};
+                std::coroutine_handle<> waiter;
+
+            public:
+
+                Operation(KvLoop& loop, OperationType operation, std::string_view key): loop(loop), operation(operation), key(key) {}
+
+                bool await_ready() const noexcept { return !KvClient::fits(key); }
+                void await_suspend(std::coroutine_handle<> handle) {
+                    waiter = handle;
+                    loop.start(this);
+                }
+                Response await_resume() const noexcept { return response; }
+        };
+
+    private:
+
+        KvClient& client;
+        std::deque<std::coroutine_handle<>> ready;
+        std::deque<Operation*> backlog;
+        std::unordered_set<void*> sessions;     // frames of spawned, unfinished sessions
+
+        bool trySubmit(Operation* op) {
+            return client.trySubmit(op->operation, op->key, [this, op](const Response& response) {
+                op->response = response;
+                ready.push_back(op->waiter);
+            });
+        }
+
+        void start(Operation* op) {
+            if (!backlog.empty() || !trySubmit(op)) backlog.push_back(op);
+        }
+
+        void flushBacklog() {
+            while (!backlog.empty() && trySubmit(backlog.front())) backlog.pop_front();
+        }
+
+        void resume(std::coroutine_handle<> handle) {
+            handle.resume();
+            if (handle.done()) {
+                auto session = std::coroutine_handle<KvTask::promise_type>::from_address(handle.address());
+                std::exception_ptr exception = session.promise().exception;
+                sessions.erase(handle.address());
+                session.destroy();
+                if (exception) std::rethrow_exception(exception);
+            }
+        }
+
+    public:
+
+        explicit KvLoop(KvClient& client): client(client) {}
+        KvLoop(const KvLoop&) = delete;
+        KvLoop& operator=(const KvLoop&) = delete;
+
+        // Sessions still suspended (ready, in the backlog or waiting on a
+        // request) are destroyed with their frames. Requests in flight complete
+        // first, since their callbacks point into those frames.
+        ~KvLoop() {
+            client.drain();
+            for (void* frame : sessions) std::coroutine_handle<>::from_address(frame).destroy();
+        }
+
+        Operation insert(std::string_view key) { return Operation(*this, INSERT, key); }
+        Operation read(std::string_view key) { return Operation(*this, READ, key); }
+        Operation remove(std::string_view key) { return Operation(*this, DELETE, key); }
+        Operation submit(OperationType operation, std::string_view key) { return Operation(*this, operation, key); }
+
+        void spawn(KvTask task) {
+            std::coroutine_handle<> handle = task.release();
+            sessions.insert(handle.address());
+            ready.push_back(handle);
+        }
+
+        // Runs until every spawned session has finished.
+        void run() {
+            while (!sessions.empty()) {
+                while (!ready.empty()) {
+                    auto handle = ready.front();
+                    ready.pop_front();
+                    resume(handle);
+                }
+                if (sessions.empty()) break;
+
+                if (client.poll() == 0) {
+                    if (client.outstanding() > 0) {
+                        client.wait();
+                    }
+                    else if (!backlog.empty()) {
+                        // Other processes hold every slot; block for one.
+                        Operation* op = backlog.front();
+                        backlog.pop_front();
+                        client.submit(op->operation, op->key, [this, op](const Response& response) {
+                            op->response = response;
+                            ready.push_back(op->waiter);
+                        });
+                    }
+                }
+                flushBacklog();
+            }
+        }
+
+        size_t sessionsLive() const { return sessions.size(); }
+};
+
+#endif
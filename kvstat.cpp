@@ -0,0 +1,189 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "stats.hpp"
+#include "spin.hpp"
+
+// Live per-stage latency percentiles from a running server's stats segment.
+// The segment is mapped read-only, so this never writes to server memory.
+//
+//   ./kvstat [interval_ms [count]] [--once] [--json]
+//
+// Every interval it prints the requests recorded since the previous one,
+// `count` times or until interrupted; --once prints everything since the
+// server started and exits. A server started with --perf adds hardware
+// counters per request for each scope; counters the server could not open
+// print as "-". --json prints each report as one line of JSON instead, with
+// times in microseconds and unavailable counters left out.
+
+#define DEFAULT_INTERVAL_MS 1000
+
+void merge(const StatsMemory* stats, HistogramSnapshot snapshot[NUM_STAGES]) {
+    uint32_t threads = std::min<uint32_t>(stats->threads.load(std::memory_order_acquire), MAX_STAT_THREADS);
+    for (int stage = 0; stage < NUM_STAGES; ++stage) {
+        snapshot[stage] = HistogramSnapshot();
+        for (uint32_t t = 0; t < threads; ++t) snapshot[stage].merge(stats->thread[t].stages[stage]);
+    }
+}
+
+struct PerfSnapshot {
+    uint64_t requests = 0;
+    uint64_t counts[NUM_PERF_COUNTERS] = {};
+
+    PerfSnapshot since(const PerfSnapshot& earlier) const {
+        PerfSnapshot delta;
+        delta.requests = requests - earlier.requests;
+        for (int i = 0; i < NUM_PERF_COUNTERS; ++i) delta.counts[i] = counts[i] - earlier.counts[i];
+        return delta;
+    }
+};
+
+void mergePerf(const StatsMemory* stats, PerfSnapshot snapshot[NUM_PERF_SCOPES]) {
+    uint32_t threads = std::min<uint32_t>(stats->threads.load(std::memory_order_acquire), MAX_STAT_THREADS);
+    for (int scope = 0; scope < NUM_PERF_SCOPES; ++scope) {
+        snapshot[scope] = PerfSnapshot();
+        for (uint32_t t = 0; t < threads; ++t) {
+            const PerfTotals& totals = stats->thread[t].perf[scope];
+            snapshot[scope].requests += totals.requests.load(std::memory_order_acquire);
+            for (int i = 0; i < NUM_PERF_COUNTERS; ++i) snapshot[scope].counts[i] += totals.counts[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void printPerf(const PerfSnapshot snapshot[NUM_PERF_SCOPES], uint32_t available) {
+    printf("%-11s %10s", "per request", "requests");
+    for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+        printf(" %13s", perfCounterName(i));
+        if (i == PERF_INSTRUCTIONS) printf(" %5s", "IPC");
+    }
+    printf("\n");
+    for (int scope = 0; scope < NUM_PERF_SCOPES; ++scope) {
+        const PerfSnapshot& p = snapshot[scope];
+        printf("%-11s %10lu", perfScopeName(scope), (unsigned long)p.requests);
+        for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+            if ((available & (1u << i)) && p.requests != 0) printf(" %13.2f", (double)p.counts[i] / p.requests);
+            else printf(" %13s", "-");
+            if (i != PERF_INSTRUCTIONS) continue;
+            uint32_t both = (1u << PERF_CYCLES) | (1u << PERF_INSTRUCTIONS);
+            if ((available & both) == both && p.counts[PERF_CYCLES] != 0) printf(" %5.2f", (double)p.counts[PERF_INSTRUCTIONS] / p.counts[PERF_CYCLES]);
+            else printf(" %5s", "-");
+        }
+        printf("\n");
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+void printJson(const HistogramSnapshot snapshot[NUM_STAGES], double seconds,
+               const PerfSnapshot perf[NUM_PERF_SCOPES], uint32_t available) {
+    printf("{\"seconds\": %.3f, \"stages\": {", seconds);
+    for (int stage = 0; stage < NUM_STAGES; ++stage) {
+        const HistogramSnapshot& h = snapshot[stage];
+        printf("%s\"%s\": {\"count\": %lu, \"rate\": %.0f, \"mean\": %.2f, \"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"p99.9\": %.2f, \"max\": %.2f}",
+               stage == 0 ? "" : ", ", stageName(stage), (unsigned long)h.total, seconds > 0 ? h.total / seconds : 0.0,
+               h.mean() / 1000.0, h.percentile(0.5) / 1000.0, h.percentile(0.9) / 1000.0, h.percentile(0.99) / 1000.0,
+               h.percentile(0.999) / 1000.0, h.max / 1000.0);
+    }
+    printf("}");
+    if (available != 0) {
+        printf(", \"perf\": {");
+        for (int scope = 0; scope < NUM_PERF_SCOPES; ++scope) {
+            const PerfSnapshot& p = perf[scope];
+            printf("%s\"%s\": {\"requests\": %lu", scope == 0 ? "" : ", ", perfScopeName(scope), (unsigned long)p.requests);
+            for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+                if ((available & (1u << i)) && p.requests != 0) printf(", \"%s\": %.2f", perfCounterName(i), (double)p.counts[i] / p.requests);
+            }
+            printf("}");
+        }
+        printf("}");
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+void print(const HistogramSnapshot snapshot[NUM_STAGES], double seconds) {
+    printf("%-11s %10s %10s %9s %9s %9s %9s %9s %9s\n",
+           "stage (us)", "count", "rate/s", "mean", "p50", "p90", "p99", "p99.9", "max");
+    for (int stage = 0; stage < NUM_STAGES; ++stage) {
+        const HistogramSnapshot& h = snapshot[stage];
+        printf("%-11s %10lu %10.0f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", stageName(stage),
+               (unsigned long)h.total, seconds > 0 ? h.total / seconds : 0.0, h.mean() / 1000.0,
+               h.percentile(0.5) / 1000.0, h.percentile(0.9) / 1000.0, h.percentile(0.99) / 1000.0,
+               h.percentile(0.999) / 1000.0, h.max / 1000.0);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+
+    int intervalMs = DEFAULT_INTERVAL_MS;
+    int count = 0;          // 0: until interrupted
+    bool once = false;
+    bool json = false;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--once") once = true;
+        else if (arg == "--json") json = true;
+        else if (positional++ == 0) intervalMs = std::stoi(arg);
+        else count = std::stoi(arg);
+    }
+
+    int stats_fd = shm_open(SHM_STATS_NAME, O_RDONLY, 0);
+    if (stats_fd == -1) {
+        perror("shm_open (is the server running with stats?)");
+        return 1;
+    }
+    void* stats_ptr = mmap(NULL, sizeof(StatsMemory), PROT_READ, MAP_SHARED, stats_fd, 0);
+    close(stats_fd);
+    if (stats_ptr == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    const StatsMemory* stats = (const StatsMemory*)stats_ptr;
+    if (stats->magic != STATS_MAGIC) {
+        fprintf(stderr, "kvstat: %s is not a stats segment of this version\n", SHM_STATS_NAME);
+        return 1;
+    }
+
+    static HistogramSnapshot previous[NUM_STAGES];
+    static HistogramSnapshot current[NUM_STAGES];
+    static HistogramSnapshot delta[NUM_STAGES];
+    PerfSnapshot perfPrevious[NUM_PERF_SCOPES];
+    PerfSnapshot perfCurrent[NUM_PERF_SCOPES];
+    PerfSnapshot perfChange[NUM_PERF_SCOPES];
+    merge(stats, current);
+    mergePerf(stats, perfCurrent);
+    if (once) {
+        double seconds = (monotonicNs() - stats->startNs) / 1e9;
+        uint32_t available = stats->perfCounters.load();
+        if (json) printJson(current, seconds, perfCurrent, available);
+        else print(current, seconds);
+        if (!json && available != 0) printPerf(perfCurrent, available);
+        return 0;
+    }
+
+    for (int report = 0; count == 0 || report < count; ++report) {
+        for (int stage = 0; stage < NUM_STAGES; ++stage) previous[stage] = current[stage];
+        for (int scope = 0; scope < NUM_PERF_SCOPES; ++scope) perfPrevious[scope] = perfCurrent[scope];
+        uint64_t begin = monotonicNs();
+        usleep(intervalMs * 1000);
+        merge(stats, current);
+        mergePerf(stats, perfCurrent);
+        for (int stage = 0; stage < NUM_STAGES; ++stage) delta[stage] = current[stage].since(previous[stage]);
+        for (int scope = 0; scope < NUM_PERF_SCOPES; ++scope) perfChange[scope] = perfCurrent[scope].since(perfPrevious[scope]);
+        double seconds = (monotonicNs() - begin) / 1e9;
+        uint32_t available = stats->perfCounters.load();
+        if (json) printJson(delta, seconds, perfChange, available);
+        else print(delta, seconds);
+        if (!json && available != 0) printPerf(perfChange, available);
+    }
+
+    return 0;
+}
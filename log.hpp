@@ -0,0 +1,223 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <csignal>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "spin.hpp"
+
+// Asynchronous binary logging. A log call copies a timestamp, a pointer to
+// its format literal and up to LOG_MAX_ARGS raw arguments into a per-thread
+// single-producer ring and returns; a background thread formats and writes
+// the events every LOG_DRAIN_US. Calls below LOG_LEVEL compile to nothing.
+// A full ring drops the event instead of blocking, and the drops are reported.
+//
+// Formats are printf formats seen through 64-bit arguments: integers are
+// widened, so use %lu / %ld, and %s only with strings of static lifetime.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_RING_DEPTH 4096     // events per thread
+#define LOG_MAX_ARGS 4
+#define LOG_DRAIN_US 1000
+
+#define LOG_DEBUG(...) do { if constexpr (LOG_LEVEL <= LOG_LEVEL_DEBUG) logEvent(__VA_ARGS__); } while (0)
+#define LOG_INFO(...) do { if constexpr (LOG_LEVEL <= LOG_LEVEL_INFO) logEvent(__VA_ARGS__); } while (0)
+#define LOG_WARN(...) do { if constexpr (LOG_LEVEL <= LOG_LEVEL_WARN) logEvent(__VA_ARGS__); } while (0)
+#define LOG_ERROR(...) do { if constexpr (LOG_LEVEL <= LOG_LEVEL_ERROR) logEvent(__VA_ARGS__); } while (0)
+
+inline uint64_t logClock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return monotonicNs();
+#endif
+}
+
+struct LogEvent {
+    uint64_t timestamp;
+    const char* format;
+    uint64_t args[LOG_MAX_ARGS];
+};
+
+// Single producer (the owning thread), single consumer (whoever drains).
+class LogRing {
+
+    private:
+
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        uint64_t cachedHead = 0;
+        LogEvent events[LOG_RING_DEPTH];
+
+    public:
+
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> owned{true};
+
+        LogEvent* claim() {
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            if (t - cachedHead >= LOG_RING_DEPTH) {
+                cachedHead = head.load(std::memory_order_acquire);
+                if (t - cachedHead >= LOG_RING_DEPTH) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+            }
+            return &events[t & (LOG_RING_DEPTH - 1)];
+        }
+
+        void publish() {
+            tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        template <typename Visitor>
+        size_t consume(Visitor visit) {
+            uint64_t h = head.load(std::memory_order_relaxed);
+            uint64_t t = tail.load(std::memory_order_acquire);
+            for (uint64_t i = h; i < t; ++i) visit(events[i & (LOG_RING_DEPTH - 1)]);
+            head.store(t, std::memory_order_release);
+            return t - h;
+        }
+};
+
+class Logger {
+
+    private:
+
+        std::mutex lock;                // ring registration and draining
+        std::vector<LogRing*> rings;    // kept for reuse once their thread exits
+        std::thread drainer;
+        std::atomic<bool> running{false};
+        FILE* out = stdout;
+        uint64_t startTicks;
+        uint64_t startNs;
+        double ticksPerNs = 1.0;
+
+        // Hands a thread's ring back for reuse when the thread exits.
+        struct Owner {
+            LogRing* ring = nullptr;
+            ~Owner() { if (ring != nullptr) ring->owned.store(false); }
+        };
+
+        Logger() {
+            startTicks = logClock();
+            startNs = monotonicNs();
+        }
+
+        ~Logger() {
+            if (running.exchange(false)) drainer.join();
+            flush();
+        }
+
+        LogRing* acquireRing() {
+            std::lock_guard<std::mutex> guard(lock);
+            for (LogRing* ring : rings) {
+                bool expected = false;
+                if (ring->owned.compare_exchange_strong(expected, true)) return ring;
+            }
+            rings.push_back(new LogRing());
+            if (!running.exchange(true)) drainer = std::thread(&Logger::drainLoop, this);
+            return rings.back();
+        }
+
+        void drainLoop() {
+            // Signals go to the other threads, so an exit() from a handler
+            // never has to join the thread it is running on.
+            sigset_t all;
+            sigfillset(&all);
+            pthread_sigmask(SIG_BLOCK, &all, nullptr);
+            while (running.load()) {
+                usleep(LOG_DRAIN_US);
+                flush();
+            }
+        }
+
+        void calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+            uint64_t elapsedNs = monotonicNs() - startNs;
+            if (elapsedNs > 1000000) ticksPerNs = (double)(logClock() - startTicks) / elapsedNs;
+#endif
+        }
+
+    public:
+
+        static Logger& instance() {
+            static Logger logger;
+            return logger;
+        }
+
+        LogRing& local() {
+            thread_local Owner owner;
+            if (owner.ring == nullptr) owner.ring = acquireRing();
+            return *owner.ring;
+        }
+
+        void setOutput(FILE* file) {
+            std::lock_guard<std::mutex> guard(lock);
+            out = file;
+        }
+
+        // Formats and writes everything logged so far.
+        void flush() {
+            std::lock_guard<std::mutex> guard(lock);
+            calibrate();
+            char line[512];
+            for (LogRing* ring : rings) {
+                ring->consume([&](const LogEvent& event) {
+                    double us = (event.timestamp - startTicks) / ticksPerNs / 1000.0;
+                    int length = snprintf(line, sizeof(line), "[%14.3f] ", us);
+                    length += snprintf(line + length, sizeof(line) - length, event.format,
+                                       event.args[0], event.args[1], event.args[2], event.args[3]);
+                    fwrite(line, 1, std::min<size_t>(length, sizeof(line) - 1), out);
+                });
+                uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+                if (dropped != 0) fprintf(out, "[log] %lu events dropped\n", (unsigned long)dropped);
+            }
+            fflush(out);
+        }
+};
+
+template <typename T>
+inline uint64_t logArg(T value) {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                  "log arguments are stored as raw 64-bit words");
+    if constexpr (std::is_pointer<T>::value) return (uint64_t)(uintptr_t)value;
+    else return (uint64_t)value;
+}
+
+template <size_t N, typename... Args>
+inline void logEvent(const char (&format)[N], Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+    LogRing& ring = Logger::instance().local();
+    LogEvent* event = ring.claim();
+    if (event == nullptr) return;
+    event->timestamp = logClock();
+    event->format = format;
+    uint64_t values[LOG_MAX_ARGS + 1] = {logArg(args)...};
+    for (int i = 0; i < LOG_MAX_ARGS; ++i) event->args[i] = values[i];
+    ring.publish();
+}
+
+inline void logFlush() {
+    Logger::instance().flush();
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+// Per-thread hardware counters through perf_event_open, read as one group so
+// a sample costs a single read(). Events the kernel or the machine cannot
+// provide (no PMU in a VM, perf_event_paranoid, seccomp) are left out and
+// reported as unavailable; context switches fall back to getrusage().
+
+enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_CONTEXT_SWITCHES,
+    NUM_PERF_COUNTERS
+};
+
+inline const char* perfCounterName(int counter) {
+    static const char* names[NUM_PERF_COUNTERS] = {"cycles", "instructions", "llc misses", "branch misses", "ctx switches"};
+    return names[counter];
+}
+
+struct PerfSample {
+    uint64_t value[NUM_PERF_COUNTERS] = {};
+};
+
+// (to - from) / parts, per counter.
+inline PerfSample perfDelta(const PerfSample& from, const PerfSample& to, uint64_t parts = 1) {
+    PerfSample delta;
+    for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+        delta.value[i] = to.value[i] >= from.value[i] ? (to.value[i] - from.value[i]) / parts : 0;
+    }
+    return delta;
+}
+
+class PerfCounters {
+
+    private:
+
+        int leader = -1;
+        int fds[NUM_PERF_COUNTERS];
+        int position[NUM_PERF_COUNTERS];    // index in the group read, -1 if not in the group
+        int members = 0;
+        uint32_t mask = 0;
+        bool rusageSwitches = false;
+
+        static int open(uint32_t type, uint64_t config, int group, bool kernel) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.exclude_kernel = !kernel;
+            attr.exclude_hv = !kernel;
+            return syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC);
+        }
+
+    public:
+
+        // Opens the counters for the calling thread.
+        PerfCounters() {
+            static const struct { uint32_t type; uint64_t config; } events[NUM_PERF_COUNTERS] = {
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+            };
+            for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+                // Hardware events may count user space only when kernel
+                // profiling is not allowed; a context switch happens in the
+                // kernel, so that one needs kernel counting or nothing.
+                int fd = open(events[i].type, events[i].config, leader, true);
+                if (fd < 0 && i != PERF_CONTEXT_SWITCHES) fd = open(events[i].type, events[i].config, leader, false);
+                fds[i] = fd;
+                position[i] = -1;
+                if (fd < 0) continue;
+                if (leader < 0) leader = fd;
+                position[i] = members++;
+                mask |= 1u << i;
+            }
+            if (!(mask & (1u << PERF_CONTEXT_SWITCHES))) {
+                rusageSwitches = true;
+                mask |= 1u << PERF_CONTEXT_SWITCHES;
+            }
+        }
+
+        ~PerfCounters() {
+            for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+                if (fds[i] >= 0) close(fds[i]);
+            }
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        // Bit i set when PerfCounter i is counted.
+        uint32_t available() const { return mask; }
+
+        // Running totals for this thread; unavailable counters read 0.
+        bool read(PerfSample& sample) const {
+            if (leader >= 0) {
+                uint64_t buffer[1 + NUM_PERF_COUNTERS];
+                if (::read(leader, buffer, sizeof(buffer)) < (ssize_t)(sizeof(uint64_t) * (1 + members))) return false;
+                for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+                    sample.value[i] = position[i] >= 0 ? buffer[1 + position[i]] : 0;
+                }
+            }
+            if (rusageSwitches) {
+                rusage usage;
+                if (getrusage(RUSAGE_THREAD, &usage) != 0) return false;
+                sample.value[PERF_CONTEXT_SWITCHES] = usage.ru_nvcsw + usage.ru_nivcsw;
+            }
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+#include <cstdint>
+
+// USDT static probes (provider "kvstore") in the SystemTap format that perf,
+// bpftrace and stap read, without needing <sys/sdt.h>. A probe is one nop
+// plus an ELF note recording its address and where each argument lives; a
+// tracer attaching replaces the nop with a breakpoint. Arguments are passed
+// as 64-bit values, so keep them to things already at hand.
+//
+//   bpftrace -e 'usdt:./server:kvstore:table_op_start { @[arg0] = count(); }'
+//
+// Build with -DKV_DISABLE_PROBES to leave even the nops out.
+
+#if !defined(KV_DISABLE_PROBES) && (defined(__x86_64__) || defined(__aarch64__))
+
+#define KV_PROBE_ASM(name, args)                                                \
+    "990: nop\n"                                                                \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                               \
+    ".balign 4\n"                                                               \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                          \
+    "991: .asciz \"stapsdt\"\n"                                                 \
+    "992: .balign 4\n"                                                          \
+    "993: .8byte 990b\n"                                                        \
+    ".8byte _.stapsdt.base\n"                                                   \
+    ".8byte 0\n"                                                                \
+    ".asciz \"kvstore\"\n"                                                      \
+    ".asciz \"" #name "\"\n"                                                    \
+    ".asciz \"" args "\"\n"                                                     \
+    "994: .balign 4\n"                                                          \
+    ".popsection\n"                                                             \
+    ".ifndef _.stapsdt.base\n"                                                  \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"     \
+    ".weak _.stapsdt.base\n"                                                    \
+    ".hidden _.stapsdt.base\n"                                                  \
+    "_.stapsdt.base: .space 1\n"                                                \
+    ".size _.stapsdt.base, 1\n"                                                 \
+    ".popsection\n"                                                             \
+    ".endif\n"
+
+#define KV_PROBE_ARG(arg) "nor"((uint64_t)(arg))
+
+#define KV_PROBE(name) __asm__ __volatile__(KV_PROBE_ASM(name, ""))
+#define KV_PROBE1(name, a1) \
+    __asm__ __volatile__(KV_PROBE_ASM(name, "8@%0") :: KV_PROBE_ARG(a1))
+#define KV_PROBE2(name, a1, a2) \
+    __asm__ __volatile__(KV_PROBE_ASM(name, "8@%0 8@%1") :: KV_PROBE_ARG(a1), KV_PROBE_ARG(a2))
+#define KV_PROBE3(name, a1, a2, a3) \
+    __asm__ __volatile__(KV_PROBE_ASM(name, "8@%0 8@%1 8@%2") :: KV_PROBE_ARG(a1), KV_PROBE_ARG(a2), KV_PROBE_ARG(a3))
+#define KV_PROBE4(name, a1, a2, a3, a4) \
+    __asm__ __volatile__(KV_PROBE_ASM(name, "8@%0 8@%1 8@%2 8@%3") :: KV_PROBE_ARG(a1), KV_PROBE_ARG(a2), KV_PROBE_ARG(a3), KV_PROBE_ARG(a4))
+
+#else
+
+#define KV_PROBE(name) do {} while (0)
+#define KV_PROBE1(name, a1) do {} while (0)
+#define KV_PROBE2(name, a1, a2) do {} while (0)
+#define KV_PROBE3(name, a1, a2, a3) do {} while (0)
+#define KV_PROBE4(name, a1, a2, a3, a4) do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef RING_H
+#define RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded multi-producer/multi-consumer ring (Vyukov style). Each cell carries
+// a sequence number telling producers and consumers whose turn it is, so the
+// only shared writes are the two position counters. The ring holds no pointers
+// and can live inside a POSIX shm segment once init() has been called.
+template <typename T, size_t N>
+class BoundedRing {
+
+    static_assert(N > 0 && (N & (N - 1)) == 0, "ring size must be a power of two");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring needs lock-free 64-bit atomics to be shared across processes");
+
+    private:
+
+        struct Cell {
+            std::atomic<uint64_t> sequence;
+            T value;
+        };
+
+        alignas(64) std::atomic<uint64_t> enqueuePos;
+        alignas(64) std::atomic<uint64_t> dequeuePos;
+        alignas(64) Cell cells[N];
+
+    public:
+
+        void init() {
+            for (size_t i = 0; i < N; i++) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            enqueuePos.store(0, std::memory_order_relaxed);
+            dequeuePos.store(0, std::memory_order_release);
+        }
+
+        bool push(const T& value) {
+            uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = cells[pos & (N - 1)];
+                uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                int64_t diff = (int64_t)sequence - (int64_t)pos;
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = value;
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;   // full
+                }
+                else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool pop(T& value) {
+            uint64_t pos = dequeuePos.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = cells[pos & (N - 1)];
+                uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                int64_t diff = (int64_t)sequence - (int64_t)(pos + 1);
+                if (diff == 0) {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        value = cell.value;
+                        cell.sequence.store(pos + N, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;   // empty
+                }
+                else {
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Approximate; only meaningful while nobody else is pushing or popping.
+        size_t size() const {
+            return (size_t)(enqueuePos.load(std::memory_order_acquire) - dequeuePos.load(std::memory_order_acquire));
+        }
+
+        static constexpr size_t capacity() { return N; }
+};
+
+#endif
@@ -8,127 +8,1236 @@
 #include <sys/stat.h>
 #include "hash.cpp"
 #include "datatypes.hpp"
+#include "channel.hpp"
+#include "futex.hpp"
+#include "spin.hpp"
+#include "log.hpp"
+#include "probes.hpp"
+#include "capture.hpp"
+#include "stats.hpp"
+#include "workqueue.hpp"
+#include "wsdeque.hpp"
+#include "topology.hpp"
 #include <semaphore.h>
-#include <queue>
 #include <csignal>
 #include <fcntl.h> 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
 
 #define SHM_REQUEST_NAME "/shared_memory_request"
-#define NUM_PROCESSING_THREADS 4
+#define NUM_PROCESSING_THREADS 4     // default pool size, see --threads
+#define MAX_PROCESSING_THREADS 64
+#define INGRESS_BATCH 16
+#define DEFAULT_IDLE_US 100
+
+#define SOCKET_CHANNEL MAX_CLIENTS      // pseudo channel id for socket requests
+#define LEGACY_CHANNEL (MAX_CLIENTS + 1) // channel id the probes report for the legacy area
+#define SOCKET_SLOTS 1024
+#define SOCKET_READ_CHUNK 65536
+#define SOCKET_INBUF_LIMIT (1 << 20)
+#define DEFAULT_UNIX_PATH "/tmp/kvserver.sock"
+#define DEFAULT_TCP_PORT 7070
+#define REQUEST_QUEUE_DEPTH 1024
+#define DEFAULT_PROCESS_BATCH 16
+#define MAX_PROCESS_BATCH 64
+#define EGRESS_BATCH 64
+#define WORKER_DEQUE_DEPTH 4096
+// Every shm and socket slot fits, so pushing a SlotRef never waits for space.
+#define STAGE_QUEUE_DEPTH (2 * MAX_CLIENTS * FIFO_DEPTH)
+
+// Pool controller: sampling period, utilisation band and the backlog per
+// active worker that counts as falling behind.
+#define POOL_CONTROL_MS 100
+#define POOL_HIGH_UTILISATION 0.85
+#define POOL_LOW_UTILISATION 0.25
+#define POOL_BACKLOG_PER_WORKER 32
 
 HashTable* tablePtr = nullptr;
 SharedMemory* sharedMemoryPtr = nullptr;
+ControlMemory* controlPtr = nullptr;
+// Filled in by the registry thread before the entry turns CLIENT_ACTIVE.
+Channel* channels[MAX_CLIENTS] = {};
 
-sem_t req_queue_size;
-sem_t req_queue_lock;
-sem_t res_queue_size;
-sem_t res_queue_lock;
-std::queue<Request> requestQueue;
-std::queue<Response> responseQueue;
+WorkQueue<Request, REQUEST_QUEUE_DEPTH> requestQueue;
+WorkQueue<Response, REQUEST_QUEUE_DEPTH> responseQueue;
 
-void processRequests() {
+// Zero-copy mode passes (channel, slot) references between the stages instead
+// of copies of the Request/Response.
+struct SlotRef {
+    uint32_t channel;
+    uint32_t index;
+};
 
-    while(true) {
+WorkQueue<SlotRef, STAGE_QUEUE_DEPTH> slotQueue;
+WorkQueue<SlotRef, STAGE_QUEUE_DEPTH> completedSlotQueue;
 
-        sem_wait(&req_queue_size);
-        sem_wait(&req_queue_lock);
-        auto request = requestQueue.front();
-        requestQueue.pop();
-        sem_post(&req_queue_lock);
+// Socket requests live in server-side slots under SOCKET_CHANNEL, so they run
+// through the same stages as shm requests. Only the frontend thread touches
+// socketOwner and socketFreeSlots.
+struct Connection;
+Slot socketSlots[SOCKET_SLOTS];
+Connection* socketOwner[SOCKET_SLOTS];
+std::vector<uint32_t> socketFreeSlots;
+BoundedRing<uint32_t, SOCKET_SLOTS> socketCompleted;
+std::atomic<bool> socketNotified(false);
+int socketEventFd = -1;
+std::string unixSocketPath;
 
-        std::cout<<"Request Dequeued\n";
+inline Slot& slotAt(const SlotRef& ref) {
+    if (ref.channel == SOCKET_CHANNEL) return socketSlots[ref.index];
+    return channels[ref.channel]->slots[ref.index];
+}
 
-        std::string input_string(request.value);
-        Response response;
-        if (request.operation == INSERT) {
-            tablePtr->insert(input_string);
-            response.requestid = request.requestid;
-            response.returntype = SUCCESS;
-            response.result = true;
-        } 
-        else if (request.operation == READ) {
-            response.requestid = request.requestid;
-            response.returntype = SUCCESS;
-            response.result = tablePtr->read(input_string);
-        } 
-        else if (request.operation == DELETE) {
-            tablePtr->remove(input_string);
-            response.requestid = request.requestid;
+// How long an idle busy-poll stage spins before parking on a futex.
+uint64_t idleSpinNs = 0;
+// Requests a pipeline worker takes per wakeup (--batch).
+size_t processBatch = DEFAULT_PROCESS_BATCH;
+bool runToCompletionMode = false;
+
+// Work-stealing mode: ingress spreads requests over one deque per worker,
+// round-robin or by key hash, and idle workers steal from busy ones. All
+// workers park on workBell.
+bool workStealingMode = false;
+bool dispatchByKey = false;
+StealDeque<SlotRef, WORKER_DEQUE_DEPTH> workerDeques[MAX_PROCESSING_THREADS];
+Doorbell workBell;
+uint32_t nextWorker = 0;
+
+// Processing pool. Workers [0, activeWorkers) take requests; the rest park on
+// poolBell after finishing the request in hand. Threads are spawned on demand
+// by the controller and never exit, so a parked worker keeps its deque and CPU.
+void (*workerMain)(int) = nullptr;
+std::atomic<int> spawnedWorkers(0);
+std::atomic<int> activeWorkers(0);
+int minWorkers = 1;
+int maxWorkers = NUM_PROCESSING_THREADS;
+int workerPinBase = 0;
+Doorbell poolBell;
+
+// Thread and memory placement (--pin, --numa-node). cpuOrder lists the CPUs
+// handed out to ingress, egress and then workers, home node first; it is empty
+// when threads are left unpinned. Channels are bound to the home node, where
+// their consumer runs.
+std::vector<int> cpuOrder;
+int homeNode = 0;
+
+// Time each worker spent executing requests, for the controller's utilisation,
+// and whether it is executing right now, for cleanup().
+struct alignas(64) WorkerLoad {
+    std::atomic<uint64_t> busyNs{0};
+    std::atomic<uint32_t> inTable{0};
+};
+WorkerLoad workerLoad[MAX_PROCESSING_THREADS];
+
+// Set by cleanup(): from then on no worker starts on the table again.
+std::atomic<bool> shuttingDown(false);
+
+// Brackets every table operation of a worker. Once cleanup() has started,
+// enterTable() never returns and the requests in hand are left unanswered:
+// the process is about to exit. Both sides use seq_cst, so either the worker
+// sees shuttingDown or cleanup() sees inTable.
+inline void enterTable(int worker) {
+    workerLoad[worker].inTable.store(1);
+    if (!shuttingDown.load()) return;
+    workerLoad[worker].inTable.store(0);
+    while (true) pause();
+}
+
+inline void leaveTable(int worker) {
+    workerLoad[worker].inTable.store(0, std::memory_order_release);
+}
+
+inline void parkIfRetired(int worker) {
+    while (worker >= activeWorkers.load(std::memory_order_acquire)) {
+        uint32_t seen = poolBell.prepareWait();
+        if (worker < activeWorkers.load()) {
+            poolBell.cancelWait();
+            return;
+        }
+        poolBell.wait(seen);
+    }
+}
+
+inline void addBusy(int worker, uint64_t begin) {
+    workerLoad[worker].busyNs.fetch_add(monotonicNs() - begin, std::memory_order_relaxed);
+}
+
+// Per-stage latency histograms in the SHM_STATS_NAME segment (kvstat reads
+// it). Every server thread claims its own ThreadStats block when it starts,
+// so recording is a handful of uncontended stores. --no-stats leaves
+// statsPtr null and skips the timestamps too, except on requests the client
+// sampled for tracing.
+StatsMemory* statsPtr = nullptr;
+thread_local ThreadStats* threadStats = nullptr;
+
+// --perf: each thread with a stats block also opens its own counter group.
+// perfLast is where the thread's current loop iteration started.
+bool perfEnabled = false;
+thread_local PerfCounters* threadPerf = nullptr;
+thread_local PerfSample perfLast;
+
+void claimStats(const char* name) {
+    if (statsPtr == nullptr) return;
+    uint32_t block = statsPtr->threads.fetch_add(1);
+    if (block >= MAX_STAT_THREADS) return;
+    threadStats = &statsPtr->thread[block];
+    strncpy(threadStats->name, name, sizeof(threadStats->name) - 1);
+    if (perfEnabled) {
+        threadPerf = new PerfCounters();
+        statsPtr->perfCounters.fetch_or(threadPerf->available());
+        threadPerf->read(perfLast);
+    }
+}
+
+// --capture: every request taken in is also appended to a capture file.
+CaptureWriter* capture = nullptr;
+
+inline void captureRequest(const Request& request) {
+    if (capture == nullptr) return;
+    capture->append(request.operation, std::string_view(request.value, strnlen(request.value, sizeof(request.value))), monotonicNs());
+}
+
+inline bool perfRead(PerfSample& sample) {
+    return threadPerf != nullptr && threadPerf->read(sample);
+}
+
+// Ends a loop iteration: charges everything counted since the previous one,
+// waiting included, to `scope`, shared by the `requests` it handled.
+inline void perfCharge(int scope, uint64_t requests) {
+    PerfSample now;
+    if (requests == 0 || !perfRead(now)) return;
+    threadStats->perf[scope].add(perfDelta(perfLast, now), requests);
+    perfLast = now;
+}
+
+inline uint64_t stamp(const StageTimes& times) {
+    return (statsPtr != nullptr || times.sampled) ? monotonicNs() : 0;
+}
+
+inline void recordStage(int stage, uint64_t from, uint64_t to) {
+    if (threadStats == nullptr || from == 0 || to < from) return;
+    threadStats->stages[stage].record(to - from);
+}
+
+// After the response is out: egress wait and the server's end-to-end view.
+inline void recordCompletion(const StageTimes& times) {
+    recordStage(STAGE_EGRESS, times.executed, times.egress);
+    recordStage(STAGE_END_TO_END, times.sent, times.egress);
+}
+
+void executeRequest(Request& request, Response& response) {
+
+    uint64_t begin = request.times.op_start = stamp(request.times);
+    PerfSample before;
+    bool counted = perfRead(before);
+    std::string_view input_string(request.value, strnlen(request.value, sizeof(request.value)));
+    response.requestid = request.requestid;
+    if (request.operation == INSERT) {
+        tablePtr->insert(input_string);
+        response.returntype = SUCCESS;
+        response.result = true;
+    } 
+    else if (request.operation == READ) {
+        response.returntype = SUCCESS;
+        response.result = tablePtr->read(input_string);
+    } 
+    else if (request.operation == DELETE) {
+        tablePtr->remove(input_string);
+        response.returntype = SUCCESS;
+        response.result = true;
+    } 
+    else {
+        response.returntype = FAILURE;
+        response.result = false;
+    } 
+    if (response.returntype == SUCCESS) {
+        request.times.executed = stamp(request.times);
+        recordStage(STAGE_OP_INSERT + request.operation, begin, request.times.executed);
+        PerfSample after;
+        if (counted && perfRead(after)) threadStats->perf[PERF_SCOPE_OP_INSERT + request.operation].add(perfDelta(before, after), 1);
+    }
+    response.times = request.times;
+}
+
+// Executes a batch grouped by bucket: requests are stably sorted by bucket
+// index, so each bucket lock is taken once per group, chains are walked in
+// bucket order, and requests for the same key keep their relative order.
+// `dequeued` is when the worker took the batch. A group's table time is
+// split evenly between its operations, and so are its counters.
+void executeBatch(Request* const* requests, Response* const* responses, size_t count, uint64_t dequeued) {
+
+    HashTable::KeyOp ops[MAX_PROCESS_BATCH];
+    std::pair<uint32_t, uint32_t> order[MAX_PROCESS_BATCH];     // (bucket, position in batch)
+    size_t valid = 0;
+    bool timed = statsPtr != nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        Request& request = *requests[i];
+        timed |= request.times.sampled;
+        request.times.dequeued = dequeued;
+        recordStage(STAGE_QUEUE, request.times.ingress, dequeued);
+        responses[i]->requestid = request.requestid;
+        responses[i]->times = request.times;
+        if (request.operation != INSERT && request.operation != READ && request.operation != DELETE) {
+            responses[i]->returntype = FAILURE;
+            responses[i]->result = false;
+            continue;
+        }
+        ops[i] = {request.operation, std::string_view(request.value, strnlen(request.value, sizeof(request.value))), false};
+        order[valid++] = {tablePtr->bucketOf(ops[i].key), (uint32_t)i};
+    }
+    std::sort(order, order + valid);
+
+    HashTable::KeyOp group[MAX_PROCESS_BATCH];
+    for (size_t first = 0; first < valid;) {
+        size_t last = first;
+        while (last < valid && order[last].first == order[first].first) {
+            group[last - first] = ops[order[last].second];
+            ++last;
+        }
+        uint64_t start = timed ? monotonicNs() : 0;
+        PerfSample before, after;
+        bool counted = perfRead(before);
+        tablePtr->applyGroup(order[first].first, group, last - first);
+        uint64_t end = timed ? monotonicNs() : 0;
+        counted = counted && perfRead(after);
+        PerfSample share = counted ? perfDelta(before, after, last - first) : PerfSample();
+        for (size_t n = first; n < last; ++n) {
+            Request& request = *requests[order[n].second];
+            Response& response = *responses[order[n].second];
+            request.times.op_start = start;
+            request.times.executed = end;
+            recordStage(STAGE_OP_INSERT + request.operation, start, start + (end - start) / (last - first));
+            if (counted) threadStats->perf[PERF_SCOPE_OP_INSERT + request.operation].add(share, 1);
             response.returntype = SUCCESS;
-            response.result = true;
-        } 
-        else {
-            response.requestid = request.requestid;
-            response.returntype = FAILURE;
-            response.result = false;
-        } 
+            response.result = group[n - first].result;
+            response.times = request.times;
+        }
+        first = last;
+    }
+}
+
+void processRequests(int worker) {
+
+    claimStats("worker");
+    Request requests[MAX_PROCESS_BATCH];
+    Response responses[MAX_PROCESS_BATCH];
+    Request* requestPtrs[MAX_PROCESS_BATCH];
+    Response* responsePtrs[MAX_PROCESS_BATCH];
+    for (size_t i = 0; i < MAX_PROCESS_BATCH; ++i) {
+        requestPtrs[i] = &requests[i];
+        responsePtrs[i] = &responses[i];
+    }
+
+    while(true) {
 
-        sem_wait(&res_queue_lock);
-        responseQueue.push(response);
-        sem_post(&res_queue_lock);
-        sem_post(&res_queue_size);
+        size_t count = requestQueue.popBatch(requests, processBatch);
+        uint64_t begin = monotonicNs();
 
-        std::cout<<"Response queued\n";
+        for (size_t i = 0; i < count; ++i) {
+            LOG_DEBUG("Request Dequeued\n");
+            KV_PROBE3(request_dequeued, requests[i].requestid, requests[i].operation, worker);
+        }
 
+        enterTable(worker);
+        executeBatch(requestPtrs, responsePtrs, count, begin);
+        leaveTable(worker);
+
+        responseQueue.pushBatch(responses, count);
+
+        for (size_t i = 0; i < count; ++i) LOG_DEBUG("Response queued\n");
+
+        addBusy(worker, begin);
+        perfCharge(PERF_SCOPE_WORKER, count);
+        parkIfRetired(worker);
     }
 }
 
 void enqueueRequests() {
+    claimStats("ingress");
     while(true) {
         sem_wait(&sharedMemoryPtr->req_available);
         // sem_wait(&sharedMemoryPtr->req_buffer_lock);
         Request request = sharedMemoryPtr->request;
         // sem_post(&sharedMemoryPtr->req_buffer_lock);
         sem_post(&sharedMemoryPtr->req_space_available);
+        request.times.ingress = stamp(request.times);
+        recordStage(STAGE_INGRESS, request.times.sent, request.times.ingress);
 
-        std::cout<<"Request Received\n";
+        LOG_DEBUG("Request Received\n");
+        KV_PROBE3(request_received, request.requestid, request.operation, LEGACY_CHANNEL);
+        captureRequest(request);
 
-        sem_wait(&req_queue_lock);
         requestQueue.push(request);
-        sem_post(&req_queue_lock);
-        sem_post(&req_queue_size);
 
-        std::cout<<"Request Queued\n";
+        LOG_DEBUG("Request Queued\n");
+        perfCharge(PERF_SCOPE_INGRESS, 1);
     }
 }
 
+// The legacy area holds a single Response, so the handshake stays per
+// response; only the hand-off from the workers is batched.
 void dequeueResponses() {
+    claimStats("egress");
+    Response responses[EGRESS_BATCH];
+    while(true) {
+        size_t count = responseQueue.popBatch(responses, EGRESS_BATCH);
+
+        for (size_t i = 0; i < count; ++i) {
+            LOG_DEBUG("Response dequeued\n");
+
+            sem_wait(&sharedMemoryPtr->res_space_available);
+            responses[i].times.egress = stamp(responses[i].times);
+            // sem_wait(&sharedMemoryPtr->res_buffer_lock);
+            sharedMemoryPtr->response = responses[i];
+            // sem_post(&sharedMemoryPtr->res_buffer_lock);
+            sem_post(&sharedMemoryPtr->res_available);
+            KV_PROBE3(response_published, responses[i].requestid, responses[i].returntype, LEGACY_CHANNEL);
+            recordCompletion(responses[i].times);
+
+            LOG_DEBUG("Response sent\n");
+        }
+        perfCharge(PERF_SCOPE_EGRESS, count);
+    }
+}
+
+Channel* initChannel(int id) {
+
+    if (channels[id] == nullptr) {
+        std::string name = SHM_CHANNEL_PREFIX + std::to_string(id);
+        int shm_fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0666);
+        if (shm_fd == -1) {
+            perror("shm_open");
+            return nullptr;
+        }
+        ftruncate(shm_fd, sizeof(Channel));
+        void* shm_ptr = mmap(NULL, sizeof(Channel), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+        close(shm_fd);
+        if (shm_ptr == MAP_FAILED) {
+            perror("mmap");
+            return nullptr;
+        }
+        if (!cpuOrder.empty()) bindMemory(shm_ptr, sizeof(Channel), MPOL_PREFERRED, 1ULL << homeNode);
+        channels[id] = (Channel*)shm_ptr;
+    }
+    else {
+        // Entry is being reused; its previous client drained every slot.
+        for (uint32_t i = 0; i < FIFO_DEPTH; ++i) sem_destroy(&channels[id]->slots[i].done);
+        sem_destroy(&channels[id]->free_available);
+    }
+
+    Channel& channel = *channels[id];
+    channel.free_slots.init();
+    channel.submitted.init();
+    channel.completed.init();
+    for (uint32_t i = 0; i < FIFO_DEPTH; ++i) {
+        sem_init(&channel.slots[i].done, 1, 0);
+        channel.free_slots.push(i);
+    }
+    sem_init(&channel.free_available, 1, FIFO_DEPTH);
+    channel.comp_bell.init();
+    return &channel;
+}
+
+void serveRegistrations() {
+    while(true) {
+        sem_wait(&controlPtr->registry_request);
+        for (int i = 0; i < MAX_CLIENTS; ++i) {
+            ClientEntry& client = controlPtr->clients[i];
+            uint32_t state = client.state.load();
+            if (state == CLIENT_REQUESTED) {
+                if (initChannel(i) == nullptr) continue;
+                snprintf(client.channel_name, sizeof(client.channel_name), "%s%d", SHM_CHANNEL_PREFIX, i);
+                client.state.store(CLIENT_ACTIVE);
+                sem_post(&client.ready);
+                LOG_INFO("Client registered\n");
+            }
+            else if (state == CLIENT_CLOSING) {
+                client.state.store(CLIENT_FREE);
+                LOG_INFO("Client closed\n");
+            }
+        }
+    }
+}
+
+// Hands a request to the workers. Ingress only: the worker deques have a single producer.
+void dispatchSlot(const SlotRef& ref) {
+    if (!workStealingMode) {
+        slotQueue.push(ref);
+        return;
+    }
+
+    // Only active workers get new requests; a resize remaps keys, which costs
+    // some cache warmth but never correctness.
+    uint32_t workers = activeWorkers.load(std::memory_order_relaxed);
+    uint32_t target;
+    if (dispatchByKey) {
+        // Same key, same worker: repeated keys find their bucket already in that core's cache.
+        const Request& request = slotAt(ref).request;
+        target = std::hash<std::string_view>()(std::string_view(request.value, strnlen(request.value, sizeof(request.value)))) % workers;
+    }
+    else {
+        target = nextWorker++ % workers;
+    }
+    for (uint32_t tries = 1; !workerDeques[target].push(ref); ++tries) {
+        target = (target + 1) % workers;
+        if (tries % workers == 0) std::this_thread::yield();
+    }
+    workBell.ring();
+}
+
+// Takes up to INGRESS_BATCH requests from each active channel per pass,
+// starting at a different channel every pass so no client can starve another.
+// Returns how many requests it took in.
+size_t pollChannels(int& start) {
+    size_t found = 0;
+    for (int n = 0; n < MAX_CLIENTS; ++n) {
+        int id = (start + n) % MAX_CLIENTS;
+        if (controlPtr->clients[id].state.load(std::memory_order_acquire) != CLIENT_ACTIVE) continue;
+
+        Channel& channel = *channels[id];
+        uint32_t index;
+        for (int taken = 0; taken < INGRESS_BATCH && channel.submitted.pop(index); ++taken) {
+            LOG_DEBUG("Request Received\n");
+            const Request& request = channel.slots[index].request;
+            KV_PROBE3(request_received, request.requestid, request.operation, id);
+            captureRequest(request);
+
+            StageTimes& times = channel.slots[index].request.times;
+            times.ingress = stamp(times);
+            recordStage(STAGE_INGRESS, times.sent, times.ingress);
+
+            dispatchSlot({(uint32_t)id, index});
+            found++;
+
+            LOG_DEBUG("Request Queued\n");
+        }
+    }
+    start = (start + 1) % MAX_CLIENTS;
+    return found;
+}
+
+void enqueueSlots() {
+    claimStats("ingress");
+    int start = 0;
+    while(true) {
+        size_t taken = pollChannels(start);
+        // Every channel looked empty: spin for idleSpinNs, then park on the doorbell.
+        if (taken == 0) spinThenPark(controlPtr->doorbell, idleSpinNs, [&]() { return (taken = pollChannels(start)) != 0; });
+        perfCharge(PERF_SCOPE_INGRESS, taken);
+    }
+}
+
+// Own deque first, then every other worker's, then requests from the socket
+// frontend. Parked workers' deques are included so nothing is stranded there.
+bool findWork(int worker, SlotRef& ref) {
+    int workers = spawnedWorkers.load(std::memory_order_acquire);
+    for (int n = 0; n < workers; ++n) {
+        if (workerDeques[(worker + n) % workers].steal(ref)) return true;
+    }
+    return slotQueue.tryPop(ref);
+}
+
+void processStealing(int worker) {
+    claimStats("worker");
+    while(true) {
+        SlotRef ref;
+        spinThenPark(workBell, idleSpinNs, [&]() { return findWork(worker, ref); });
+        uint64_t begin = monotonicNs();
+
+        LOG_DEBUG("Request Dequeued\n");
+
+        Slot& slot = slotAt(ref);
+        KV_PROBE3(request_dequeued, slot.request.requestid, slot.request.operation, worker);
+        slot.request.times.dequeued = begin;
+        recordStage(STAGE_QUEUE, slot.request.times.ingress, begin);
+        enterTable(worker);
+        executeRequest(slot.request, slot.response);
+        leaveTable(worker);
+
+        completedSlotQueue.push(ref);
+
+        LOG_DEBUG("Response queued\n");
+
+        addBusy(worker, begin);
+        perfCharge(PERF_SCOPE_WORKER, 1);
+        parkIfRetired(worker);
+    }
+}
+
+void processSlots(int worker) {
+    claimStats("worker");
+    SlotRef refs[MAX_PROCESS_BATCH];
+    Request* requests[MAX_PROCESS_BATCH];
+    Response* responses[MAX_PROCESS_BATCH];
+    while(true) {
+        size_t count = slotQueue.popBatch(refs, processBatch);
+        uint64_t begin = monotonicNs();
+
+        for (size_t i = 0; i < count; ++i) {
+            LOG_DEBUG("Request Dequeued\n");
+            Slot& slot = slotAt(refs[i]);
+            KV_PROBE3(request_dequeued, slot.request.requestid, slot.request.operation, worker);
+            requests[i] = &slot.request;
+            responses[i] = &slot.response;
+        }
+
+        enterTable(worker);
+        executeBatch(requests, responses, count, begin);
+        leaveTable(worker);
+
+        completedSlotQueue.pushBatch(refs, count);
+
+        for (size_t i = 0; i < count; ++i) LOG_DEBUG("Response queued\n");
+
+        addBusy(worker, begin);
+        perfCharge(PERF_SCOPE_WORKER, count);
+        parkIfRetired(worker);
+    }
+}
+
+// Hands the slot back to whoever is waiting on it, according to its notify type.
+bool notifySlot(const SlotRef& ref) {
+
+    if (ref.channel == SOCKET_CHANNEL) {
+        // Hand back to the frontend; one eventfd write covers every
+        // completion it has not picked up yet.
+        while (!socketCompleted.push(ref.index)) {}
+        if (!socketNotified.exchange(true)) {
+            uint64_t one = 1;
+            write(socketEventFd, &one, sizeof(one));
+        }
+        return false;
+    }
+
+    // The client recycles the slot once it has read the response.
+    Channel& channel = *channels[ref.channel];
+    Slot& slot = channel.slots[ref.index];
+    if (slot.notify == NOTIFY_POLL) {
+        if (slot.state.exchange(SLOT_DONE) == SLOT_PARKED) futexWake(&slot.state, 1);
+    }
+    else if (slot.notify == NOTIFY_RING) {
+        while (!channel.completed.push(ref.index)) {}
+        return true;
+    }
+    else {
+        sem_post(&slot.done);
+    }
+    return false;
+}
+
+// Publishes a finished slot to whoever is waiting for it. Returns true when
+// the client still has to be woken through its channel's comp_bell, which
+// the caller rings once for all the slots it published.
+bool publishSlot(const SlotRef& ref) {
+
+    // Copied first: the slot may be reused as soon as it is published.
+    Slot& slot = slotAt(ref);
+    StageTimes& live = slot.request.times;
+    live.egress = stamp(live);
+    StageTimes times = live;
+    uint64_t requestid = slot.response.requestid;
+    uint64_t returntype = slot.response.returntype;
+    bool ring = notifySlot(ref);
+    KV_PROBE3(response_published, requestid, returntype, ref.channel);
+    recordCompletion(times);
+    return ring;
+}
+
+void completeSlot(const SlotRef& ref) {
+    if (publishSlot(ref)) channels[ref.channel]->comp_bell.ring();
+}
+
+// Publishes every completion that is ready, then wakes each pipelined client
+// once for the whole batch instead of once per response.
+void dequeueSlots() {
+    static_assert(MAX_CLIENTS <= 64, "one wake bit per channel");
+    claimStats("egress");
+    SlotRef refs[EGRESS_BATCH];
+    while(true) {
+        size_t count = completedSlotQueue.popBatch(refs, EGRESS_BATCH);
+
+        uint64_t wake = 0;
+        for (size_t i = 0; i < count; ++i) {
+            LOG_DEBUG("Response dequeued\n");
+            if (publishSlot(refs[i])) wake |= 1ULL << refs[i].channel;
+        }
+        for (; wake != 0; wake &= wake - 1) channels[__builtin_ctzll(wake)]->comp_bell.ring();
+
+        for (size_t i = 0; i < count; ++i) LOG_DEBUG("Response sent\n");
+        perfCharge(PERF_SCOPE_EGRESS, count);
+    }
+}
+
+// Run-to-completion: take one request straight off a channel's submitted ring
+// (or the socket frontend's queue), execute it and complete it on this thread.
+// `start` rotates so every channel gets its turn.
+bool serveOne(int worker, int& start) {
+    SlotRef ref;
+    bool found = false;
+    for (int n = 0; n < MAX_CLIENTS && !found; ++n) {
+        int id = (start + n) % MAX_CLIENTS;
+        if (controlPtr->clients[id].state.load(std::memory_order_acquire) != CLIENT_ACTIVE) continue;
+        if (channels[id]->submitted.pop(ref.index)) {
+            ref.channel = id;
+            start = (id + 1) % MAX_CLIENTS;
+            found = true;
+        }
+    }
+    if (!found && !slotQueue.tryPop(ref)) return false;
+    uint64_t begin = monotonicNs();
+
+    LOG_DEBUG("Request Dequeued\n");
+
+    // Shm requests go straight from the channel to this worker; socket ones
+    // were stamped by the frontend.
+    Slot& slot = slotAt(ref);
+    StageTimes& times = slot.request.times;
+    if (found) {
+        times.ingress = begin;
+        recordStage(STAGE_INGRESS, times.sent, begin);
+        KV_PROBE3(request_received, slot.request.requestid, slot.request.operation, ref.channel);
+        captureRequest(slot.request);
+    }
+    KV_PROBE3(request_dequeued, slot.request.requestid, slot.request.operation, worker);
+    times.dequeued = begin;
+    recordStage(STAGE_QUEUE, times.ingress, begin);
+    enterTable(worker);
+    executeRequest(slot.request, slot.response);
+    leaveTable(worker);
+    completeSlot(ref);
+
+    LOG_DEBUG("Response sent\n");
+
+    addBusy(worker, begin);
+    perfCharge(PERF_SCOPE_WORKER, 1);
+    return true;
+}
+
+void runToCompletion(int worker) {
+    claimStats("worker");
+    int start = worker % MAX_CLIENTS;
     while(true) {
-        sem_wait(&res_queue_size);
-        sem_wait(&res_queue_lock);
-        Response response = responseQueue.front();
-        responseQueue.pop();
-        sem_post(&res_queue_lock);
+        parkIfRetired(worker);
+        if (serveOne(worker, start)) continue;
+        spinThenPark(controlPtr->doorbell, idleSpinNs, [&]() { return serveOne(worker, start); });
+    }
+}
 
-        std::cout<<"Response dequeued\n";
+// Requests waiting for a processing thread, whatever the mode.
+size_t pendingWork() {
+    size_t depth = requestQueue.size() + slotQueue.size();
+    for (int i = 0; i < spawnedWorkers.load(); ++i) depth += workerDeques[i].size();
+    if (runToCompletionMode) {
+        for (int id = 0; id < MAX_CLIENTS; ++id) {
+            if (controlPtr->clients[id].state.load(std::memory_order_acquire) != CLIENT_ACTIVE) continue;
+            depth += channels[id]->submitted.size();
+        }
+    }
+    return depth;
+}
 
-        sem_wait(&sharedMemoryPtr->res_space_available);
-        // sem_wait(&sharedMemoryPtr->res_buffer_lock);
-        sharedMemoryPtr->response = response;
-        // sem_post(&sharedMemoryPtr->res_buffer_lock);
-        sem_post(&sharedMemoryPtr->res_available);
+std::mutex poolLock;
+bool poolRetired = false;
 
-        std::cout<<"Response sent\n";
+// False once cleanup() has frozen the pool.
+bool setActiveWorkers(int count) {
+    std::lock_guard<std::mutex> guard(poolLock);
+    if (poolRetired) return false;
+    for (int worker = spawnedWorkers.load(); worker < count; ++worker) {
+        std::thread thread(workerMain, worker);
+        if (!cpuOrder.empty()) {
+            if (!pinThread(thread, cpuOrder[(workerPinBase + worker) % cpuOrder.size()])) std::cerr << "pthread_setaffinity_np failed\n";
+        }
+        thread.detach();
+        spawnedWorkers.store(worker + 1);
     }
+    activeWorkers.store(count);
+    poolBell.ringAll();
+    return true;
+}
+
+// Shutdown: freezes the pool, then waits until no worker is executing. Ingress
+// keeps dispatching to the active workers, but they stop in enterTable().
+void retirePool() {
+    {
+        std::lock_guard<std::mutex> guard(poolLock);
+        poolRetired = true;
+    }
+    shuttingDown.store(true);
+    for (int worker = 0; worker < spawnedWorkers.load(); ++worker) {
+        while (workerLoad[worker].inTable.load() != 0) cpuRelax();
+    }
+}
+
+// Every POOL_CONTROL_MS: grow the pool (doubling, for bursts) while workers are
+// saturated or a backlog builds up, shrink it one worker at a time once they
+// sit mostly idle with nothing queued.
+void controlPool() {
+    uint64_t lastBusy[MAX_PROCESSING_THREADS] = {};
+    uint64_t lastTick = monotonicNs();
+    while(true) {
+        usleep(POOL_CONTROL_MS * 1000);
+
+        uint64_t now = monotonicNs();
+        uint64_t busy = 0;
+        for (int i = 0; i < spawnedWorkers.load(); ++i) {
+            uint64_t total = workerLoad[i].busyNs.load(std::memory_order_relaxed);
+            busy += total - lastBusy[i];
+            lastBusy[i] = total;
+        }
+        int active = activeWorkers.load();
+        double utilisation = (double)busy / ((double)(now - lastTick) * active);
+        lastTick = now;
+        size_t backlog = pendingWork();
+
+        int target = active;
+        if (utilisation > POOL_HIGH_UTILISATION || backlog > (size_t)active * POOL_BACKLOG_PER_WORKER)
+            target = std::min(maxWorkers, active * 2);
+        else if (utilisation < POOL_LOW_UTILISATION && backlog == 0)
+            target = std::max(minWorkers, active - 1);
+        if (target != active) {
+            if (!setActiveWorkers(target)) return;
+            LOG_INFO("Processing threads: %lu\n", (uint64_t)target);
+        }
+    }
+}
+
+enum ConnectionKind {
+    CONN_CLIENT,
+    CONN_LISTEN_UNIX,
+    CONN_LISTEN_TCP,
+    CONN_EVENT
+};
+
+// Per-socket state of the frontend. Frames are parsed straight out of `in`;
+// responses are batched in `out` and written once per wakeup.
+struct Connection {
+    int fd;
+    ConnectionKind kind;
+    std::vector<char> in;
+    size_t inStart = 0;
+    std::vector<char> out;
+    size_t outStart = 0;
+    uint32_t inFlight = 0;
+    bool closed = false;
+    bool stalled = false;       // parsing stopped because no socket slot was free
+    bool readBlocked = false;   // stopped reading because `in` hit SOCKET_INBUF_LIMIT
+    bool dirty = false;
+
+    Connection(int fd, ConnectionKind kind): fd(fd), kind(kind) {}
+};
+
+class SocketFrontend {
+
+    private:
+
+        int epollFd = -1;
+        std::vector<Connection*> stalled;
+        std::vector<Connection*> dirty;
+        std::vector<Connection*> graveyard;
+
+        bool watch(Connection* conn, uint32_t events) {
+            struct epoll_event event;
+            event.events = events;
+            event.data.ptr = conn;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, conn->fd, &event) == -1) {
+                perror("epoll_ctl");
+                return false;
+            }
+            return true;
+        }
+
+        void closeConnection(Connection* conn) {
+            if (conn->closed) return;
+            if (conn->stalled) {
+                stalled.erase(std::find(stalled.begin(), stalled.end(), conn));
+                conn->stalled = false;
+            }
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+            close(conn->fd);
+            conn->closed = true;
+            // Requests still in the stages point at conn; free it after they drain.
+            if (conn->inFlight == 0) graveyard.push_back(conn);
+            LOG_INFO("Socket closed\n");
+        }
+
+        void parse(Connection* conn) {
+            size_t available = conn->in.size() - conn->inStart;
+            while (available >= sizeof(WireRequestHeader)) {
+                WireRequestHeader header;
+                memcpy(&header, conn->in.data() + conn->inStart, sizeof(header));
+                size_t frameSize = sizeof(header) + header.length;
+                if (available < frameSize) break;
+                if (socketFreeSlots.empty()) {
+                    if (!conn->stalled) stalled.push_back(conn);
+                    conn->stalled = true;
+                    break;
+                }
+
+                uint32_t index = socketFreeSlots.back();
+                socketFreeSlots.pop_back();
+                Request& request = socketSlots[index].request;
+                request.requestid = header.requestid;
+                request.operation = static_cast<OperationType>(header.operation);
+                memcpy(request.value, conn->in.data() + conn->inStart + sizeof(header), header.length);
+                request.value[header.length] = '\0';
+                // The frame arrival stands in for the client's send time.
+                request.times.sampled = 0;
+                request.times.sent = request.times.ingress = stamp(request.times);
+                socketOwner[index] = conn;
+                conn->inFlight++;
+
+                LOG_DEBUG("Request Received\n");
+                KV_PROBE3(request_received, request.requestid, request.operation, SOCKET_CHANNEL);
+                captureRequest(request);
+
+                slotQueue.push({SOCKET_CHANNEL, index});
+                // Run-to-completion workers park on the control doorbell and
+                // work-stealing workers on workBell; both also poll slotQueue.
+                if (runToCompletionMode) controlPtr->doorbell.ring();
+                if (workStealingMode) workBell.ring();
+
+                LOG_DEBUG("Request Queued\n");
+
+                conn->inStart += frameSize;
+                available -= frameSize;
+            }
+            if (conn->inStart == conn->in.size()) {
+                conn->in.clear();
+                conn->inStart = 0;
+            }
+            else if (conn->inStart > conn->in.size() / 2) {
+                conn->in.erase(conn->in.begin(), conn->in.begin() + conn->inStart);
+                conn->inStart = 0;
+            }
+        }
+
+        // Edge-triggered: keep reading until EAGAIN so no readiness is lost.
+        void readConnection(Connection* conn) {
+            conn->readBlocked = false;
+            while (true) {
+                if (conn->in.size() - conn->inStart >= SOCKET_INBUF_LIMIT) {
+                    conn->readBlocked = true;
+                    break;
+                }
+                size_t used = conn->in.size();
+                conn->in.resize(used + SOCKET_READ_CHUNK);
+                ssize_t n = read(conn->fd, conn->in.data() + used, SOCKET_READ_CHUNK);
+                conn->in.resize(used + (n > 0 ? n : 0));
+                if (n > 0) continue;
+                if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                if (n == -1 && errno == EINTR) continue;
+                parse(conn);
+                closeConnection(conn);
+                return;
+            }
+            parse(conn);
+        }
+
+        void flush(Connection* conn) {
+            while (!conn->closed && conn->outStart < conn->out.size()) {
+                ssize_t n = send(conn->fd, conn->out.data() + conn->outStart, conn->out.size() - conn->outStart, MSG_NOSIGNAL);
+                if (n > 0) {
+                    conn->outStart += n;
+                }
+                else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    return;     // EPOLLOUT will tell us when to continue
+                }
+                else if (n == -1 && errno == EINTR) {
+                    continue;
+                }
+                else {
+                    closeConnection(conn);
+                    return;
+                }
+            }
+            conn->out.clear();
+            conn->outStart = 0;
+        }
+
+        void accept(Connection* listener) {
+            while (true) {
+                int fd = accept4(listener->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd == -1) {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("accept4");
+                    if (errno == EINTR) continue;
+                    return;
+                }
+                if (listener->kind == CONN_LISTEN_TCP) {
+                    int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                }
+                Connection* conn = new Connection(fd, CONN_CLIENT);
+                if (!watch(conn, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET)) {
+                    close(fd);
+                    delete conn;
+                    continue;
+                }
+                LOG_INFO("Socket accepted\n");
+            }
+        }
+
+        // Turns every completion published by the response stage into a
+        // response frame on its connection's output batch.
+        void drainCompletions() {
+            socketNotified.exchange(false);
+            uint32_t index;
+            while (socketCompleted.pop(index)) {
+                Connection* conn = socketOwner[index];
+                const Response& response = socketSlots[index].response;
+                socketFreeSlots.push_back(index);
+                conn->inFlight--;
+                if (conn->closed) {
+                    if (conn->inFlight == 0) graveyard.push_back(conn);
+                    continue;
+                }
+                WireResponse frame{response.requestid, (uint8_t)response.returntype, (uint8_t)response.result};
+                const char* bytes = reinterpret_cast<const char*>(&frame);
+                conn->out.insert(conn->out.end(), bytes, bytes + sizeof(frame));
+                if (!conn->dirty) dirty.push_back(conn);
+                conn->dirty = true;
+            }
+            for (Connection* conn : dirty) {
+                conn->dirty = false;
+                flush(conn);
+            }
+            dirty.clear();
+        }
+
+        void resumeStalled() {
+            std::vector<Connection*> retry;
+            retry.swap(stalled);
+            for (Connection* conn : retry) {
+                conn->stalled = false;
+                if (conn->closed) continue;
+                if (conn->readBlocked) readConnection(conn);
+                else parse(conn);
+            }
+        }
+
+    public:
+
+        int listenUnix(const std::string& path) {
+            int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd == -1) {
+                perror("socket");
+                return -1;
+            }
+            struct sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+            unlink(path.c_str());
+            if (bind(fd, (struct sockaddr*)&address, sizeof(address)) == -1 || listen(fd, SOMAXCONN) == -1) {
+                perror("bind/listen unix");
+                close(fd);
+                return -1;
+            }
+            return watch(new Connection(fd, CONN_LISTEN_UNIX), EPOLLIN | EPOLLET) ? fd : -1;
+        }
+
+        int listenTcp(int port) {
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd == -1) {
+                perror("socket");
+                return -1;
+            }
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            struct sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (bind(fd, (struct sockaddr*)&address, sizeof(address)) == -1 || listen(fd, SOMAXCONN) == -1) {
+                perror("bind/listen tcp");
+                close(fd);
+                return -1;
+            }
+            return watch(new Connection(fd, CONN_LISTEN_TCP), EPOLLIN | EPOLLET) ? fd : -1;
+        }
+
+        bool init() {
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+            socketEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epollFd == -1 || socketEventFd == -1) {
+                perror("epoll_create1/eventfd");
+                return false;
+            }
+            socketCompleted.init();
+            for (uint32_t i = SOCKET_SLOTS; i > 0; --i) socketFreeSlots.push_back(i - 1);
+            return watch(new Connection(socketEventFd, CONN_EVENT), EPOLLIN | EPOLLET);
+        }
+
+        void run() {
+            struct epoll_event events[64];
+            while(true) {
+                int count = epoll_wait(epollFd, events, 64, -1);
+                if (count == -1) {
+                    if (errno == EINTR) continue;
+                    perror("epoll_wait");
+                    return;
+                }
+                size_t freeBefore = socketFreeSlots.size();
+                for (int i = 0; i < count; ++i) {
+                    Connection* conn = (Connection*)events[i].data.ptr;
+                    if (conn->kind == CONN_LISTEN_UNIX || conn->kind == CONN_LISTEN_TCP) {
+                        accept(conn);
+                    }
+                    else if (conn->kind == CONN_EVENT) {
+                        uint64_t value;
+                        while (read(socketEventFd, &value, sizeof(value)) > 0) {}
+                        drainCompletions();
+                    }
+                    else if (!conn->closed) {
+                        if (events[i].events & EPOLLOUT) flush(conn);
+                        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) readConnection(conn);
+                    }
+                }
+                if (socketFreeSlots.size() > freeBefore && !stalled.empty()) resumeStalled();
+                for (Connection* conn : graveyard) delete conn;
+                graveyard.clear();
+            }
+        }
+};
+
+SocketFrontend socketFrontend;
+
+void serveSockets() {
+    socketFrontend.run();
 }
 
 void cleanup(int sig) {
 
+    // No worker touches the table after this, so it can be walked and freed.
+    retirePool();
+    if (tablePtr != nullptr) {
+        TableFootprint footprint = tablePtr->footprint();
+        std::cout << "Table memory: " << footprint.keys << " keys, " << footprint.total() << " bytes, "
+                  << footprint.perKey() << " bytes/key (buckets " << footprint.bucketArray << ", locks " << footprint.locks
+                  << ", list nodes " << footprint.listNodes << ", strings " << footprint.stringHeaders
+                  << ", long keys " << footprint.keyBytes << ", heap overhead " << footprint.heapOverhead << ")" << std::endl;
+    }
+
     munmap(sharedMemoryPtr, sizeof(SharedMemory));
     shm_unlink(SHM_REQUEST_NAME);
+    if (!unixSocketPath.empty()) unlink(unixSocketPath.c_str());
+
+    if (controlPtr != nullptr) {
+        for (int i = 0; i < MAX_CLIENTS; ++i) {
+            if (channels[i] == nullptr) continue;
+            munmap(channels[i], sizeof(Channel));
+            shm_unlink((SHM_CHANNEL_PREFIX + std::to_string(i)).c_str());
+        }
+        munmap(controlPtr, sizeof(ControlMemory));
+        shm_unlink(SHM_CONTROL_NAME);
+    }
+
+    if (capture != nullptr) {
+        uint64_t dropped = capture->close();
+        if (dropped != 0) std::cerr << "Capture full: " << dropped << " requests not captured" << std::endl;
+    }
+
+    // Left mapped: workers may still be recording; exit() drops it.
+    if (statsPtr != nullptr) shm_unlink(SHM_STATS_NAME);
 
     delete tablePtr;
+    logFlush();
     exit(0);
 }
 
 int main(int argc, char* argv[]) {
 
     if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <table_size>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <table_size> [--zero-copy] [--busy-poll [--idle-us <us>]]"
+                  << " [--listen [--unix <path>] [--tcp-port <port>]]"
+                  << " [--run-to-completion | --work-stealing [--dispatch rr|key]]"
+                  << " [--threads <n>] [--min-threads <n>] [--max-threads <n>] [--batch <k>]"
+                  << " [--pin] [--numa-node <node>] [--pin-base <n>] [--no-stats | --perf]"
+                  << " [--capture <file> [--capture-mb <n>]]" << std::endl;
         return 1;
     }
+
+    // SIGINT stays blocked in every server thread (each inherits this mask)
+    // and is taken with sigwait() at the end of main, so cleanup() never runs
+    // on a thread interrupted in the middle of a capture append or a table
+    // operation.
+    sigset_t interrupt;
+    sigemptyset(&interrupt);
+    sigaddset(&interrupt, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &interrupt, nullptr);
+
     int tableSize = std::stoi(argv[1]);
-    tablePtr = new HashTable(tableSize);
+    bool zeroCopy = false;
+    bool busyPoll = false;
+    uint64_t idleUs = DEFAULT_IDLE_US;
+    int pinBase = 0;
+    bool pinThreads = false;
+    int numaNode = -1;
+    bool collectStats = true;
+    std::string captureFile;
+    uint64_t captureMb = DEFAULT_CAPTURE_MB;
+    bool listenSockets = false;
+    std::string unixPath = DEFAULT_UNIX_PATH;
+    int tcpPort = DEFAULT_TCP_PORT;
+    int numWorkers = NUM_PROCESSING_THREADS;
+    int minThreads = 0;
+    int maxThreads = 0;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--zero-copy") zeroCopy = true;
+        else if (arg == "--busy-poll") busyPoll = zeroCopy = true;
+        else if (arg == "--idle-us" && i + 1 < argc) idleUs = std::stoull(argv[++i]);
+        else if (arg == "--pin-base" && i + 1 < argc) pinBase = std::stoi(argv[++i]);
+        else if (arg == "--pin") pinThreads = true;
+        else if (arg == "--no-stats") collectStats = false;
+        else if (arg == "--perf") perfEnabled = true;
+        else if (arg == "--capture" && i + 1 < argc) captureFile = argv[++i];
+        else if (arg == "--capture-mb" && i + 1 < argc) captureMb = std::stoull(argv[++i]);
+        else if (arg == "--numa-node" && i + 1 < argc) numaNode = std::stoi(argv[++i]), pinThreads = true;
+        else if (arg == "--listen") listenSockets = zeroCopy = true;
+        else if (arg == "--run-to-completion") runToCompletionMode = zeroCopy = true;
+        else if (arg == "--work-stealing") workStealingMode = zeroCopy = true;
+        else if (arg == "--dispatch" && i + 1 < argc) dispatchByKey = std::string(argv[++i]) == "key";
+        else if (arg == "--unix" && i + 1 < argc) unixPath = argv[++i];
+        else if (arg == "--tcp-port" && i + 1 < argc) tcpPort = std::stoi(argv[++i]);
+        else if (arg == "--batch" && i + 1 < argc) processBatch = std::max(1, std::min(std::stoi(argv[++i]), MAX_PROCESS_BATCH));
+        else if (arg == "--threads" && i + 1 < argc) numWorkers = std::stoi(argv[++i]);
+        else if (arg == "--min-threads" && i + 1 < argc) minThreads = std::stoi(argv[++i]);
+        else if (arg == "--max-threads" && i + 1 < argc) maxThreads = std::stoi(argv[++i]);
+    }
+    // Without --min-threads/--max-threads the pool stays at --threads.
+    numWorkers = std::max(1, std::min(numWorkers, MAX_PROCESSING_THREADS));
+    maxWorkers = maxThreads > 0 ? std::max(numWorkers, std::min(maxThreads, MAX_PROCESSING_THREADS)) : numWorkers;
+    minWorkers = minThreads > 0 ? std::min(minThreads, numWorkers) : (maxThreads > 0 ? 1 : numWorkers);
+
+    if (pinThreads || busyPoll) {
+        Topology topology;
+        homeNode = numaNode;
+        if (!topology.hasNode(homeNode)) {
+            if (numaNode != -1) std::cerr << "NUMA node " << numaNode << " has no CPUs, using the current one\n";
+            homeNode = topology.nodeOf(sched_getcpu());
+        }
+        std::vector<int> order = topology.placementOrder(homeNode);
+        for (size_t i = 0; i < order.size(); ++i) cpuOrder.push_back(order[(pinBase + i) % order.size()]);
+        workerPinBase = runToCompletionMode ? 0 : 2;
+
+        // Unpinned threads (registry, sockets) and first-touch allocations stay on the home node.
+        if (!pinCurrentThread(topology.cpusOf(homeNode))) std::cerr << "pthread_setaffinity_np failed\n";
+
+        // The table lives on the nodes its workers run on, interleaved if they span several.
+        uint64_t workerNodes = 0;
+        for (int i = 0; i < workerPinBase + maxWorkers; ++i) workerNodes |= 1ULL << topology.nodeOf(cpuOrder[i % cpuOrder.size()]);
+        setMemoryPolicy(__builtin_popcountll(workerNodes) > 1 ? MPOL_INTERLEAVE : MPOL_PREFERRED, workerNodes);
+        tablePtr = new HashTable(tableSize);
+        setMemoryPolicy(MPOL_DEFAULT, 0);
+    }
+    else {
+        tablePtr = new HashTable(tableSize);
+    }
 
     int shm_fd = shm_open(SHM_REQUEST_NAME, O_CREAT | O_RDWR, 0666);
     if (shm_fd == -1) {
@@ -152,24 +1261,120 @@ int main(int argc, char* argv[]) {
     sem_init(&sharedMemoryPtr->res_space_available, 1, 1); 
     // sem_init(&sharedMemoryPtr->res_buffer_lock, 1, 1);
 
-    sem_init(&req_queue_lock, 0, 1);
-    sem_init(&res_queue_lock, 0, 1);
-    sem_init(&req_queue_size, 0, 0);
-    sem_init(&res_queue_size, 0, 0);
+    if (zeroCopy) {
+        int control_fd = shm_open(SHM_CONTROL_NAME, O_CREAT | O_RDWR, 0666);
+        if (control_fd == -1) {
+            perror("shm_open");
+            exit(1);
+        }
+        ftruncate(control_fd, sizeof(ControlMemory));
+
+        void* control_ptr = mmap(NULL, sizeof(ControlMemory), PROT_READ | PROT_WRITE, MAP_SHARED, control_fd, 0);
+        if (control_ptr == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
+        if (!cpuOrder.empty()) bindMemory(control_ptr, sizeof(ControlMemory), MPOL_PREFERRED, 1ULL << homeNode);
+        controlPtr = (ControlMemory*)control_ptr;
+
+        sem_init(&controlPtr->registry_lock, 1, 1);
+        sem_init(&controlPtr->registry_request, 1, 0);
+        controlPtr->doorbell.init();
+        for (int i = 0; i < MAX_CLIENTS; ++i) {
+            controlPtr->clients[i].state.store(CLIENT_FREE);
+            sem_init(&controlPtr->clients[i].ready, 1, 0);
+        }
+    }
+
+    // Socket requests feed the same slot stages as the zero-copy channels.
+    if (listenSockets) {
+        if (!socketFrontend.init()) exit(1);
+        if (socketFrontend.listenUnix(unixPath) == -1) exit(1);
+        unixSocketPath = unixPath;
+        if (socketFrontend.listenTcp(tcpPort) == -1) exit(1);
+    }
+
+    if (collectStats) {
+        // Created 0644: kvstat and other readers map it read-only.
+        int stats_fd = shm_open(SHM_STATS_NAME, O_CREAT | O_RDWR, 0644);
+        if (stats_fd == -1) {
+            perror("shm_open");
+            exit(1);
+        }
+        ftruncate(stats_fd, 0);
+        ftruncate(stats_fd, sizeof(StatsMemory));
+        void* stats_ptr = mmap(NULL, sizeof(StatsMemory), PROT_READ | PROT_WRITE, MAP_SHARED, stats_fd, 0);
+        close(stats_fd);
+        if (stats_ptr == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
+        statsPtr = (StatsMemory*)stats_ptr;
+        statsPtr->startNs = monotonicNs();
+        statsPtr->threads.store(0);
+        statsPtr->perfCounters.store(0);
+        statsPtr->magic = STATS_MAGIC;
+    }
 
-    signal(SIGINT, cleanup);
+    if (!captureFile.empty()) {
+        capture = new CaptureWriter();
+        if (!capture->open(captureFile.c_str(), captureMb << 20)) {
+            perror("capture");
+            exit(1);
+        }
+    }
+
+    if (perfEnabled && !collectStats) {
+        std::cerr << "--perf reports through the stats segment; ignored with --no-stats" << std::endl;
+        perfEnabled = false;
+    }
+    if (perfEnabled) {
+        PerfCounters probe;
+        for (int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+            if (!(probe.available() & (1u << counter))) std::cerr << "perf: " << perfCounterName(counter) << " not available" << std::endl;
+        }
+    }
+
+    workBell.init();
 
     std::vector<std::thread> threads;
-    threads.emplace_back(&dequeueResponses);
-    for (int i = 0; i < NUM_PROCESSING_THREADS; ++i) { 
-        threads.emplace_back(&processRequests);
+    if (zeroCopy) {
+        if (busyPoll) {
+            idleSpinNs = idleUs * 1000;
+            slotQueue.setSpin(idleSpinNs);
+            completedSlotQueue.setSpin(idleSpinNs);
+        }
+
+        if (runToCompletionMode) {
+            workerMain = &runToCompletion;
+        }
+        else {
+            workerMain = workStealingMode ? &processStealing : &processSlots;
+            threads.emplace_back(&enqueueSlots);
+            threads.emplace_back(&dequeueSlots);
+        }
+
+        threads.emplace_back(&serveRegistrations);
+        if (listenSockets) threads.emplace_back(&serveSockets);
+    }
+    else {
+        workerMain = &processRequests;
+        threads.emplace_back(&dequeueResponses);
+        threads.emplace_back(&enqueueRequests);
     }
-    threads.emplace_back(&enqueueRequests);
 
-    for (auto& thread : threads) {
-        if(thread.joinable())
-            thread.join();
+    // Ingress and egress take the first CPUs of the placement order, then one
+    // per worker as the pool grows. The registry and socket threads block.
+    for (int i = 0; i < workerPinBase && !cpuOrder.empty(); ++i) {
+        if (!pinThread(threads[i], cpuOrder[i % cpuOrder.size()])) std::cerr << "pthread_setaffinity_np failed\n";
     }
 
+    setActiveWorkers(numWorkers);
+    if (minWorkers < maxWorkers) threads.emplace_back(&controlPool);
+
+    // The server threads never return; the process ends in cleanup().
+    int sig;
+    sigwait(&interrupt, &sig);
+    cleanup(sig);
     return 0;
 }
@@ -0,0 +1,101 @@
+#ifndef SPIN_H
+#define SPIN_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "futex.hpp"
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+inline uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+inline bool pinThread(std::thread& thread, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+}
+
+// Futex wake word plus a count of parked waiters, so ring() costs one atomic
+// increment and only makes a syscall when somebody is actually asleep. Holds
+// only atomics and may be placed in shm.
+struct Doorbell {
+    std::atomic<uint32_t> word;
+    std::atomic<uint32_t> sleepers;
+
+    void init() {
+        word.store(0);
+        sleepers.store(0);
+    }
+
+    void ring(int count = 1) {
+        word.fetch_add(1);
+        if (sleepers.load() != 0) futexWake(&word, count);
+    }
+
+    void ringAll() {
+        word.fetch_add(1);
+        if (sleepers.load() != 0) futexWake(&word);
+    }
+
+    // A waiter calls prepareWait(), re-checks its condition, then either
+    // cancelWait() or wait(). Any ring() after prepareWait() either makes the
+    // re-check succeed or changes `word` so wait() returns at once.
+    uint32_t prepareWait() {
+        sleepers.fetch_add(1);
+        return word.load();
+    }
+
+    void cancelWait() {
+        sleepers.fetch_sub(1);
+    }
+
+    // A timeout is relative, as for futexWait().
+    void wait(uint32_t seen, const struct timespec* timeout = nullptr) {
+        futexWait(&word, seen, timeout);
+        sleepers.fetch_sub(1);
+    }
+};
+
+// NAPI-style wait: poll `ready` with cpuRelax() for up to spinNs, then park on
+// `bell` until a ring() makes `ready` succeed. spinNs == 0 parks right away.
+template <typename Predicate>
+void spinThenPark(Doorbell& bell, uint64_t spinNs, Predicate ready) {
+    if (ready()) return;
+    if (spinNs > 0) {
+        uint64_t deadline = monotonicNs() + spinNs;
+        for (uint32_t i = 1;; ++i) {
+            if (ready()) return;
+            cpuRelax();
+            if ((i & 63) == 0 && monotonicNs() >= deadline) break;
+        }
+    }
+    while (true) {
+        uint32_t seen = bell.prepareWait();
+        if (ready()) {
+            bell.cancelWait();
+            return;
+        }
+        bell.wait(seen);
+        if (ready()) return;
+    }
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "histogram.hpp"
+#include "perf.hpp"
+
+#define SHM_STATS_NAME "/shared_memory_stats"
+#define STATS_MAGIC 0x026b7673746174ULL   // "kvstat", layout version 2
+#define MAX_STAT_THREADS 80
+
+// Request stages timed by the server, in nanoseconds between StageTimes stamps.
+enum Stage {
+    STAGE_INGRESS,      // client published -> ingress picked it up from shm
+    STAGE_QUEUE,        // ingress -> a worker took it off the stage queue
+    STAGE_OP_INSERT,    // hash table operation, by type
+    STAGE_OP_READ,
+    STAGE_OP_DELETE,
+    STAGE_EGRESS,       // operation done -> response published to the client
+    STAGE_END_TO_END,   // client published -> response published
+    NUM_STAGES
+};
+
+inline const char* stageName(int stage) {
+    static const char* names[NUM_STAGES] = {"ingress", "queue", "op insert", "op read", "op delete", "egress", "end-to-end"};
+    return names[stage];
+}
+
+// Where the server's hardware counters are charged (--perf). The loop scopes
+// cover a thread's whole iteration, waiting included, so semaphore and futex
+// sleeps show up as context switches; the op scopes cover only the table.
+enum PerfScope {
+    PERF_SCOPE_INGRESS,     // per request taken in
+    PERF_SCOPE_WORKER,      // per request executed
+    PERF_SCOPE_OP_INSERT,   // hash table operation, by type
+    PERF_SCOPE_OP_READ,
+    PERF_SCOPE_OP_DELETE,
+    PERF_SCOPE_EGRESS,      // per response published
+    NUM_PERF_SCOPES
+};
+
+inline const char* perfScopeName(int scope) {
+    static const char* names[NUM_PERF_SCOPES] = {"ingress", "worker", "op insert", "op read", "op delete", "egress"};
+    return names[scope];
+}
+
+// Counter totals and the requests they cover. Single writer, like Histogram.
+struct PerfTotals {
+    std::atomic<uint64_t> requests;
+    std::atomic<uint64_t> counts[NUM_PERF_COUNTERS];
+
+    void add(const PerfSample& delta, uint64_t covered) {
+        for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+            counts[i].store(counts[i].load(std::memory_order_relaxed) + delta.value[i], std::memory_order_relaxed);
+        }
+        requests.store(requests.load(std::memory_order_relaxed) + covered, std::memory_order_release);
+    }
+};
+
+// One block per server thread, so every histogram has a single writer.
+struct ThreadStats {
+    char name[16];
+    Histogram stages[NUM_STAGES];
+    PerfTotals perf[NUM_PERF_SCOPES];
+};
+
+// Read-only for everyone but the server. Each server thread claims the next
+// block by bumping `threads`; blocks start zeroed, so a reader can merge the
+// first `threads` blocks at any time.
+struct StatsMemory {
+    uint64_t magic;
+    uint64_t startNs;
+    std::atomic<uint32_t> threads;
+    std::atomic<uint32_t> perfCounters;     // PerfCounter bits any thread counts, 0 without --perf
+    alignas(64) ThreadStats thread[MAX_STAT_THREADS];
+};
+
+#endif
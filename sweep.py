@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""End-to-end scalability sweep.
+
+Starts a fresh server and client for every combination of transport, client
+threads, server threads and table size, all set on the command line, and
+reads the measurement window from the server's stats segment with kvstat.
+Results go to JSON and/or CSV. With --baseline, every configuration that is
+also in the baseline is compared, and the exit status is 1 if throughput
+fell or end-to-end p99 rose by more than --tolerance.
+
+    ./sweep.py --transports zero-copy,async --client-threads 1,2,4 \\
+               --server-threads 1,2,4 --table-sizes 100000 --json results.json
+    ./sweep.py ... --baseline results.json --tolerance 0.15
+
+Build with logging off first (--build does it) so the measurement is not
+dominated by log events.
+"""
+
+import argparse
+import csv
+import itertools
+import json
+import os
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+
+SOCKET_PATH = "/tmp/kvsweep.sock"
+TCP_PORT = "7071"
+
+# transport: (server flags, client flags)
+TRANSPORTS = {
+    "shm": ([], []),
+    "zero-copy": (["--zero-copy"], ["--zero-copy"]),
+    "busy-poll": (["--busy-poll"], ["--busy-poll"]),
+    "async": (["--zero-copy"], ["--async"]),
+    "coro": (["--zero-copy"], ["--coro"]),
+    "unix": (["--listen", "--unix", SOCKET_PATH], ["--unix", SOCKET_PATH]),
+    "tcp": (["--listen", "--tcp-port", TCP_PORT], ["--tcp", TCP_PORT]),
+}
+
+KEY_FIELDS = ["transport", "client_threads", "server_threads", "table_size"]
+LATENCY_FIELDS = ["mean_us", "p50_us", "p90_us", "p99_us", "p99.9_us", "max_us"]
+
+
+def number_list(text):
+    return [int(item) for item in text.split(",") if item]
+
+
+def kvstat(args, directory):
+    """Runs kvstat with --json and returns its first report, or None."""
+    command = [os.path.join(directory, "kvstat")] + args + ["--json"]
+    result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0 or not result.stdout.strip():
+        return None
+    return json.loads(result.stdout.splitlines()[0])
+
+
+def stop(process, timeout=10):
+    if process.poll() is not None:
+        return
+    process.send_signal(signal.SIGINT)
+    try:
+        process.wait(timeout=timeout)
+    except subprocess.TimeoutExpired:
+        process.kill()
+        process.wait()
+
+
+def run_one(options, transport, client_threads, server_threads, table_size):
+    """One server and client run; returns a result row, or None on failure."""
+    server_flags, client_flags = TRANSPORTS[transport]
+    directory = options.dir
+    server_command = [os.path.join(directory, "server"), str(table_size), "--threads", str(server_threads)]
+    server_command += server_flags + options.server_args.split()
+    server_log = tempfile.TemporaryFile("w+")
+    server = subprocess.Popen(server_command, stdout=subprocess.DEVNULL, stderr=server_log)
+
+    # The stats segment appears once the server is set up.
+    deadline = time.monotonic() + 10
+    while kvstat(["--once"], directory) is None:
+        if server.poll() is not None or time.monotonic() > deadline:
+            stop(server)
+            server_log.seek(0)
+            print(f"  server did not start: {server_log.read().strip()}", file=sys.stderr)
+            return None
+        time.sleep(0.05)
+    time.sleep(options.settle)
+
+    run_seconds = options.warmup + options.duration + 1
+    client_command = [os.path.join(directory, "client"), "--threads", str(client_threads),
+                      "--duration", str(run_seconds)] + client_flags + options.client_args.split()
+    client_log = tempfile.TemporaryFile("w+")
+    client = subprocess.Popen(client_command, stdout=subprocess.DEVNULL, stderr=client_log)
+
+    time.sleep(options.warmup)
+    report = kvstat([str(int(options.duration * 1000)), "1"], directory)
+    try:
+        client.wait(timeout=run_seconds + 10)
+    except subprocess.TimeoutExpired:
+        client.kill()
+        client.wait()
+    stop(server)
+    if report is None or client.returncode != 0:
+        client_log.seek(0)
+        print(f"  run failed: {client_log.read().strip()}", file=sys.stderr)
+        return None
+
+    end_to_end = report["stages"]["end-to-end"]
+    row = {
+        "transport": transport,
+        "client_threads": client_threads,
+        "server_threads": server_threads,
+        "table_size": table_size,
+        "seconds": report["seconds"],
+        "requests": end_to_end["count"],
+        "throughput": end_to_end["rate"],
+    }
+    for field in LATENCY_FIELDS:
+        row[field] = end_to_end[field[:-3]]
+    row["stages"] = report["stages"]
+    if "perf" in report:
+        row["perf"] = report["perf"]
+    return row
+
+
+def key_of(row):
+    return tuple(row[field] for field in KEY_FIELDS)
+
+
+def compare(rows, baseline_rows, tolerance):
+    """Prints throughput and p99 against the baseline; returns the regressions."""
+    baseline = {key_of(row): row for row in baseline_rows}
+    regressions = []
+    print(f"\n{'configuration':<36} {'throughput':>12} {'baseline':>12} {'p99 us':>10} {'baseline':>10}")
+    for row in rows:
+        old = baseline.get(key_of(row))
+        name = "{} c{} s{} t{}".format(*key_of(row))
+        if old is None:
+            print(f"{name:<36} {row['throughput']:>12.0f} {'-':>12} {row['p99_us']:>10.2f} {'-':>10}")
+            continue
+        problems = []
+        if row["throughput"] < old["throughput"] * (1 - tolerance):
+            problems.append("throughput")
+        if row["p99_us"] > old["p99_us"] * (1 + tolerance):
+            problems.append("p99")
+        flag = "  REGRESSED: " + ", ".join(problems) if problems else ""
+        print(f"{name:<36} {row['throughput']:>12.0f} {old['throughput']:>12.0f} "
+              f"{row['p99_us']:>10.2f} {old['p99_us']:>10.2f}{flag}")
+        if problems:
+            regressions.append((name, problems))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--transports", default="zero-copy",
+                        help="comma-separated: " + ", ".join(TRANSPORTS))
+    parser.add_argument("--client-threads", type=number_list, default=[1, 2, 4])
+    parser.add_argument("--server-threads", type=number_list, default=[1, 2, 4])
+    parser.add_argument("--table-sizes", type=number_list, default=[100000])
+    parser.add_argument("--duration", type=float, default=3, help="measured seconds per run")
+    parser.add_argument("--warmup", type=float, default=1, help="unmeasured seconds before the window")
+    parser.add_argument("--settle", type=float, default=0.3, help="seconds between server start and client start")
+    parser.add_argument("--server-args", default="", help="extra server flags, e.g. '--run-to-completion'")
+    parser.add_argument("--client-args", default="", help="extra client flags, e.g. '--ycsb B --load'")
+    parser.add_argument("--json", help="write the results as JSON")
+    parser.add_argument("--csv", help="write the results as CSV")
+    parser.add_argument("--baseline", help="JSON results of an earlier sweep to compare against")
+    parser.add_argument("--tolerance", type=float, default=0.10,
+                        help="allowed throughput drop and p99 rise, as a fraction (default 0.10)")
+    parser.add_argument("--build", action="store_true", help="rebuild server, client and kvstat with logging off")
+    parser.add_argument("--dir", default=os.path.dirname(os.path.abspath(__file__)),
+                        help="directory holding server, client and kvstat")
+    options = parser.parse_args()
+
+    transports = [name for name in options.transports.split(",") if name]
+    for name in transports:
+        if name not in TRANSPORTS:
+            parser.error(f"unknown transport {name}")
+    if options.build:
+        subprocess.run(["make", "-B", "-C", options.dir, "LOG_LEVEL=LOG_LEVEL_OFF", "server", "client", "kvstat"],
+                       check=True, stdout=subprocess.DEVNULL)
+    if kvstat(["--once"], options.dir) is not None:
+        sys.exit("A server is already running (or left its stats segment behind); stop it first.")
+
+    rows = []
+    failures = 0
+    for transport, client_threads, server_threads, table_size in itertools.product(
+            transports, options.client_threads, options.server_threads, options.table_sizes):
+        print(f"{transport} client_threads={client_threads} server_threads={server_threads} table_size={table_size}",
+              file=sys.stderr)
+        row = run_one(options, transport, client_threads, server_threads, table_size)
+        if row is None:
+            failures += 1
+            continue
+        print(f"  {row['throughput']:.0f} req/s  p50 {row['p50_us']:.2f} us  p99 {row['p99_us']:.2f} us",
+              file=sys.stderr)
+        rows.append(row)
+
+    if options.json:
+        with open(options.json, "w") as f:
+            json.dump({"cpus": os.cpu_count(), "duration": options.duration, "server_args": options.server_args,
+                       "client_args": options.client_args, "results": rows}, f, indent=2)
+    if options.csv:
+        with open(options.csv, "w", newline="") as f:
+            writer = csv.writer(f)
+            fields = KEY_FIELDS + ["seconds", "requests", "throughput"] + LATENCY_FIELDS
+            writer.writerow(fields)
+            for row in rows:
+                writer.writerow([row[field] for field in fields])
+
+    regressions = []
+    if options.baseline:
+        with open(options.baseline) as f:
+            regressions = compare(rows, json.load(f)["results"], options.tolerance)
+        if regressions:
+            print(f"\n{len(regressions)} configuration(s) regressed beyond {options.tolerance:.0%}", file=sys.stderr)
+    if failures:
+        print(f"{failures} run(s) failed", file=sys.stderr)
+    sys.exit(1 if regressions or failures else 0)
+
+
+if __name__ == "__main__":
+    main()
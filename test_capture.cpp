@@ -0,0 +1,195 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "capture.hpp"
+#include "workload.hpp"
+
+std::string capturePath() {
+    return "/tmp/test_capture." + std::to_string(getpid());
+}
+
+void testRoundTrip() {
+    // Records come back in order with their keys, operations and times
+    std::string path = capturePath();
+    CaptureWriter writer;
+    assert(writer.open(path.c_str(), 1 << 16));
+    uint64_t start = monotonicNs();
+    writer.append(INSERT, "alpha", start + 1000);
+    writer.append(READ, "b", start + 2000);
+    writer.append(DELETE, "", start + 3000);
+    assert(writer.close() == 0);
+
+    CaptureReader reader;
+    assert(reader.open(path.c_str()));
+    assert(reader.size() == 3);
+    assert(reader.dropped() == 0);
+    assert(reader.at(0).operation == INSERT && reader.at(0).key == "alpha");
+    assert(reader.at(1).operation == READ && reader.at(1).key == "b");
+    assert(reader.at(2).operation == DELETE && reader.at(2).key.empty());
+    assert(reader.at(0).timeNs < reader.at(1).timeNs && reader.at(1).timeNs < reader.at(2).timeNs);
+    unlink(path.c_str());
+}
+
+void testFull() {
+    // Requests that do not fit are counted, not written
+    std::string path = capturePath();
+    CaptureWriter writer;
+    assert(writer.open(path.c_str(), 2 * (sizeof(CaptureRecord) + 4)));
+    for (int i = 0; i < 5; i++) writer.append(READ, "abcd", monotonicNs());
+    assert(writer.close() == 3);
+
+    CaptureReader reader;
+    assert(reader.open(path.c_str()));
+    assert(reader.size() == 2);
+    assert(reader.dropped() == 3);
+    unlink(path.c_str());
+}
+
+void testConcurrentWriters() {
+    // Every thread's records survive, each one whole
+    std::string path = capturePath();
+    CaptureWriter writer;
+    assert(writer.open(path.c_str(), 1 << 20));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&writer, t]() {
+            std::string key(t + 1, 'a' + t);
+            for (int i = 0; i < 1000; i++) writer.append(INSERT, key, monotonicNs());
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    writer.close();
+
+    CaptureReader reader;
+    assert(reader.open(path.c_str()));
+    assert(reader.size() == 4000);
+    size_t perThread[4] = {};
+    for (size_t i = 0; i < reader.size(); i++) {
+        std::string_view key = reader.at(i).key;
+        int t = key[0] - 'a';
+        assert(t >= 0 && t < 4 && key == std::string(t + 1, 'a' + t));
+        perThread[t]++;
+    }
+    for (int t = 0; t < 4; t++) assert(perThread[t] == 1000);
+    unlink(path.c_str());
+}
+
+void testUnfinishedRecord() {
+    // A record reserved but never finished ends the readable capture
+    std::string path = capturePath();
+    CaptureWriter writer;
+    assert(writer.open(path.c_str(), 1 << 16));
+    writer.append(READ, "one", monotonicNs());
+    writer.append(READ, "two", monotonicNs());
+    writer.append(READ, "three", monotonicNs());
+    writer.close();
+
+    int fd = open(path.c_str(), O_RDWR);
+    uint8_t zero = 0;
+    off_t second = sizeof(CaptureHeader) + sizeof(CaptureRecord) + 3 + offsetof(CaptureRecord, operation);
+    assert(pwrite(fd, &zero, 1, second) == 1);
+    close(fd);
+
+    CaptureReader reader;
+    assert(reader.open(path.c_str()));
+    assert(reader.size() == 1);
+    assert(reader.at(0).key == "one");
+    unlink(path.c_str());
+}
+
+void testInvalidOperation() {
+    // Operations off the wire that are not INSERT, READ or DELETE are left out
+    std::string path = capturePath();
+    CaptureWriter writer;
+    assert(writer.open(path.c_str(), 1 << 16));
+    writer.append(READ, "one", monotonicNs());
+    writer.append((OperationType)255, "bad", monotonicNs());
+    writer.append((OperationType)7, "bad", monotonicNs());
+    writer.append(DELETE, "two", monotonicNs());
+    assert(writer.close() == 0);
+
+    CaptureReader reader;
+    assert(reader.open(path.c_str()));
+    assert(reader.size() == 2);
+    assert(reader.at(1).operation == DELETE && reader.at(1).key == "two");
+    unlink(path.c_str());
+}
+
+void testReplay() {
+    // Replay cursors split the capture between them in order and wrap around
+    std::string path = capturePath();
+    CaptureWriter writer;
+    assert(writer.open(path.c_str(), 1 << 16));
+    for (int i = 0; i < 10; i++) writer.append(i % 2 ? READ : INSERT, std::to_string(i), monotonicNs());
+    writer.close();
+
+    CaptureReader reader;
+    assert(reader.open(path.c_str()));
+    Workload workload(reader, 0);
+    assert(workload.loadSize() == 0);
+    assert(workload.streamSize() == 10);
+
+    Workload::Cursor first = workload.cursor(0, 3);
+    Workload::Cursor second = workload.cursor(1, 3);
+    assert(!first.loading());
+    for (int i : {0, 3, 6, 9, 2, 5}) {
+        WorkloadOp op = first.next();
+        assert(op.key == std::to_string(i) && op.operation == (i % 2 ? READ : INSERT));
+    }
+    for (int i : {1, 4, 7, 0}) assert(second.next().key == std::to_string(i));
+    unlink(path.c_str());
+}
+
+void testReplayPacing() {
+    // At recorded speed the replay takes as long as the capture did; at
+    // double speed about half as long
+    std::string path = capturePath();
+    CaptureWriter writer;
+    assert(writer.open(path.c_str(), 1 << 16));
+    uint64_t start = monotonicNs();
+    for (int i = 0; i < 5; i++) writer.append(READ, "k", start + i * 10000000ULL);
+    writer.close();
+
+    CaptureReader reader;
+    assert(reader.open(path.c_str()));
+    for (double speed : {1.0, 2.0}) {
+        Workload workload(reader, speed);
+        Workload::Cursor cursor = workload.cursor();
+        uint64_t begin = monotonicNs();
+        for (int i = 0; i < 5; i++) cursor.next();
+        double elapsedMs = (monotonicNs() - begin) / 1e6;
+        assert(elapsedMs >= 40 / speed - 1 && elapsedMs < 40 / speed + 30);
+    }
+    unlink(path.c_str());
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testRoundTrip();
+    std::cout << "Round Trip test passed.\n";
+
+    testFull();
+    std::cout << "Full test passed.\n";
+
+    testConcurrentWriters();
+    std::cout << "Concurrent Writers test passed.\n";
+
+    testUnfinishedRecord();
+    std::cout << "Unfinished Record test passed.\n";
+
+    testInvalidOperation();
+    std::cout << "Invalid Operation test passed.\n";
+
+    testReplay();
+    std::cout << "Replay test passed.\n";
+
+    testReplayPacing();
+    std::cout << "Replay Pacing test passed.\n";
+
+    std::cout << "All tests passed.\n";
+    return 0;
+}
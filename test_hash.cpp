@@ -61,6 +61,54 @@ void testEmptyTable() {
     hashTable.remove("apple");  // Should not crash or do anything
 }
 
+void testApplyGroup() {
+    HashTable hashTable(1); // Every key lands in bucket 0
+    uint32_t index = hashTable.bucketOf("apple");
+    assert(index == hashTable.bucketOf("banana"));
+
+    // Operations apply in order: the READ sees the INSERT before it, not the REMOVE after it
+    HashTable::KeyOp ops[] = {
+        {INSERT, "apple", false},
+        {READ, "apple", false},
+        {READ, "banana", false},
+        {DELETE, "apple", false},
+        {READ, "apple", true},
+    };
+    hashTable.applyGroup(index, ops, 5);
+    assert(ops[0].result == true);
+    assert(ops[1].result == true);
+    assert(ops[2].result == false);
+    assert(ops[3].result == true);
+    assert(ops[4].result == false);
+    assert(hashTable.read("apple") == false);
+
+    HashTable::KeyOp reads[] = {{READ, "apple", true}, {READ, "cherry", true}};  // Read-only group
+    hashTable.applyGroup(index, reads, 2);
+    assert(reads[0].result == false && reads[1].result == false);
+}
+
+void testFootprint() {
+    HashTable hashTable(10);
+    TableFootprint empty = hashTable.footprint();
+    assert(empty.keys == 0);
+    assert(empty.locks == 10 * sizeof(std::shared_mutex));
+    assert(empty.listNodes == 0 && empty.keyBytes == 0);
+
+    // A short key lives inside its std::string, a long one on the heap
+    hashTable.insert("apple");
+    hashTable.insert(std::string(40, 'x'));
+    TableFootprint footprint = hashTable.footprint();
+    assert(footprint.keys == 2);
+    assert(footprint.stringHeaders == 2 * sizeof(std::string));
+    assert(footprint.keyBytes >= 41);
+    assert(footprint.heapOverhead > empty.heapOverhead);
+    assert(footprint.total() > empty.total() + 2 * sizeof(std::string) + 41);
+    assert(footprint.perKey() == footprint.total() / 2.0);
+
+    hashTable.remove("apple");
+    assert(hashTable.footprint().keys == 1);
+}
+
 int main() {
     std::cout << "Running tests...\n";
     
@@ -75,6 +123,12 @@ int main() {
     
     testEmptyTable();
     std::cout << "Empty Table test passed.\n";
+
+    testApplyGroup();
+    std::cout << "Apply Group test passed.\n";
+
+    testFootprint();
+    std::cout << "Footprint test passed.\n";
     
     std::cout << "All tests passed.\n";
     
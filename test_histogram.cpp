@@ -0,0 +1,77 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include "histogram.hpp"
+
+void testBuckets() {
+    // Small values are exact, and buckets tile the range without gaps
+    for (uint64_t v = 0; v < 16; v++) assert(histBucket(v) == v);
+    for (size_t b = 0; b + 1 < HIST_BUCKETS; b++) {
+        assert(histBucket(histBucketLow(b)) == b);
+        assert(histBucket(histBucketHigh(b)) == b);
+        assert(histBucketHigh(b) + 1 == histBucketLow(b + 1));
+    }
+
+    // Relative error stays within 1/16
+    for (uint64_t v = 16; v < (1ULL << 40); v = v * 3 + 7) {
+        size_t b = histBucket(v);
+        assert(histBucketLow(b) <= v && v <= histBucketHigh(b));
+        assert((histBucketHigh(b) - histBucketLow(b)) * 16 <= histBucketLow(b));
+    }
+    assert(histBucket(UINT64_MAX) == HIST_BUCKETS - 1);  // Overflow bucket
+}
+
+void testPercentiles() {
+    static Histogram histogram;
+    for (uint64_t v = 1; v <= 1000; v++) histogram.record(v * 1000);
+
+    HistogramSnapshot snapshot;
+    snapshot.merge(histogram);
+    assert(snapshot.total == 1000);
+    assert(snapshot.max == 1000000);
+    assert(snapshot.mean() == 500500.0);
+
+    uint64_t p50 = snapshot.percentile(0.5);
+    assert(p50 >= 500000 && p50 <= 500000 * 17 / 16);
+    uint64_t p99 = snapshot.percentile(0.99);
+    assert(p99 >= 990000 && p99 <= 1000000);
+    assert(snapshot.percentile(1.0) == 1000000);
+}
+
+void testMergeAndSince() {
+    static Histogram a;
+    static Histogram b;
+    a.record(100);
+    b.record(200);
+    b.record(300);
+
+    HistogramSnapshot first;
+    first.merge(a);
+    first.merge(b);
+    assert(first.total == 3 && first.sum == 600 && first.max == 300);
+
+    a.record(5000);
+    HistogramSnapshot second;
+    second.merge(a);
+    second.merge(b);
+    HistogramSnapshot delta = second.since(first);
+    assert(delta.total == 1 && delta.sum == 5000);
+    assert(delta.percentile(0.5) >= 5000);
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testBuckets();
+    std::cout << "Buckets test passed.\n";
+
+    testPercentiles();
+    std::cout << "Percentiles test passed.\n";
+
+    testMergeAndSince();
+    std::cout << "Merge and Since test passed.\n";
+
+    std::cout << "All tests passed.\n";
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "kvclient.hpp"
+#include "kvcoro.hpp"
+
+// In-process stand-in for the server's zero-copy path: takes slots off the
+// submitted ring, applies them to a multiset and hands them back on the
+// completed ring, as the egress stage does for NOTIFY_RING slots.
+class FakeServer {
+
+    private:
+
+        Channel& channel;
+        std::multiset<std::string> keys;
+        std::thread thread;
+        std::atomic<bool> running{true};
+
+        void serve() {
+            uint32_t index;
+            while (running.load()) {
+                if (!channel.submitted.pop(index)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                Slot& slot = channel.slots[index];
+                std::string key(slot.request.value);
+                bool result = true;
+                if (slot.request.operation == INSERT) keys.insert(key);
+                else if (slot.request.operation == READ) result = keys.count(key) != 0;
+                else if (keys.count(key) != 0) keys.erase(keys.find(key));
+                else result = false;
+                slot.response.requestid = slot.request.requestid + (mismatch.load() ? 1 : 0);
+                slot.response.returntype = SUCCESS;
+                slot.response.result = result;
+                channel.completed.push(index);
+                channel.comp_bell.ring();
+            }
+        }
+
+    public:
+
+        std::atomic<bool> mismatch{false};      // answer with the wrong requestid
+
+        explicit FakeServer(Channel& channel): channel(channel), thread(&FakeServer::serve, this) {}
+        ~FakeServer() {
+            running.store(false);
+            thread.join();
+        }
+};
+
+ControlMemory control;
+Channel channel;
+
+void resetChannel(ClientChannel& connection) {
+    control.doorbell.init();
+    channel.free_slots.init();
+    channel.submitted.init();
+    channel.completed.init();
+    for (uint32_t i = 0; i < FIFO_DEPTH; ++i) channel.free_slots.push(i);
+    sem_init(&channel.free_available, 0, FIFO_DEPTH);
+    channel.comp_bell.init();
+    connection.attach(control, channel);
+}
+
+void testSubmitGet() {
+    // Futures complete through get() with the server's answers
+    ClientChannel connection;
+    resetChannel(connection);
+    FakeServer server(channel);
+    KvClient client(connection);
+
+    std::future<Response> inserted = client.insert("alpha");
+    Response response = client.get(inserted);
+    assert(response.returntype == SUCCESS && response.result);
+
+    std::future<Response> found = client.read("alpha");
+    std::future<Response> missing = client.read("beta");
+    assert(client.get(found).result == true);
+    assert(client.get(missing).result == false);
+
+    std::string tooLong(sizeof(Request::value), 'x');
+    std::future<Response> rejected = client.read(tooLong);
+    assert(client.get(rejected).returntype == FAILURE);     // Key does not fit
+    assert(client.outstanding() == 0);
+}
+
+void testPollCallbacks() {
+    // More requests than slots: submit() waits for its own completions
+    ClientChannel connection;
+    resetChannel(connection);
+    FakeServer server(channel);
+    KvClient client(connection);
+
+    const int count = FIFO_DEPTH * 4;
+    int completed = 0;
+    for (int i = 0; i < count; ++i) {
+        bool submitted = client.submit(INSERT, "key" + std::to_string(i % 10), [&](const Response& response) {
+            assert(response.returntype == SUCCESS);
+            completed++;
+        });
+        assert(submitted);
+        client.poll();
+    }
+    while (client.outstanding() > 0) {
+        if (client.poll() == 0) std::this_thread::yield();
+    }
+    assert(completed == count);
+    assert(client.poll() == 0);     // Nothing left to complete
+}
+
+void testMismatchFails() {
+    // A response carrying another request's id fails the request instead of hanging get()
+    ClientChannel connection;
+    resetChannel(connection);
+    FakeServer server(channel);
+    server.mismatch.store(true);
+    KvClient client(connection);
+
+    std::future<Response> future = client.insert("alpha");
+    Response response = client.get(future);
+    assert(response.returntype == FAILURE);
+    assert(client.outstanding() == 0);
+}
+
+KvTask countKeys(KvLoop& kv, int session, int& found) {
+    std::string key = "session" + std::to_string(session);
+    for (int i = 0; i < 8; ++i) co_await kv.insert(key);
+    Response response = co_await kv.read(key);
+    if (response.result) found++;
+    co_await kv.remove(key);
+}
+
+void testLoop() {
+    // Sessions with more operations in flight than slots all finish
+    ClientChannel connection;
+    resetChannel(connection);
+    FakeServer server(channel);
+    KvClient client(connection);
+    KvLoop loop(client);
+
+    const int sessions = FIFO_DEPTH + 50;
+    int found = 0;
+    for (int i = 0; i < sessions; ++i) loop.spawn(countKeys(loop, i, found));
+    loop.run();
+    assert(found == sessions);
+    assert(loop.sessionsLive() == 0);
+    assert(client.outstanding() == 0);
+}
+
+struct FrameGuard {
+    int& destroyed;
+    ~FrameGuard() { destroyed++; }
+};
+
+KvTask failAfterInsert(KvLoop& kv, int& destroyed) {
+    FrameGuard guard{destroyed};
+    co_await kv.insert("fail");
+    throw std::runtime_error("session failed");
+}
+
+KvTask keepReading(KvLoop& kv, int& destroyed) {
+    FrameGuard guard{destroyed};
+    while (true) co_await kv.read("key");
+}
+
+void testLoopDestroysSessions() {
+    // Sessions left suspended when run() throws are destroyed with the loop,
+    // whether they wait in the backlog, on a request or to be resumed
+    ClientChannel connection;
+    resetChannel(connection);
+    FakeServer server(channel);
+    KvClient client(connection);
+
+    const int sessions = FIFO_DEPTH + 50;
+    int destroyed = 0;
+    {
+        KvLoop loop(client);
+        loop.spawn(failAfterInsert(loop, destroyed));
+        for (int i = 1; i < sessions; ++i) loop.spawn(keepReading(loop, destroyed));
+        bool threw = false;
+        try {
+            loop.run();
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        assert(destroyed == 1);
+        assert(loop.sessionsLive() == (size_t)sessions - 1);
+    }
+    assert(destroyed == sessions);
+    assert(client.outstanding() == 0);
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testSubmitGet();
+    std::cout << "Submit Get test passed.\n";
+
+    testPollCallbacks();
+    std::cout << "Poll Callbacks test passed.\n";
+
+    testMismatchFails();
+    std::cout << "Mismatch Fails test passed.\n";
+
+    testLoop();
+    std::cout << "Loop test passed.\n";
+
+    testLoopDestroysSessions();
+    std::cout << "Loop Destroys Sessions test passed.\n";
+
+    std::cout << "All tests passed.\n";
+    return 0;
+}
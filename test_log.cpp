@@ -0,0 +1,91 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "log.hpp"
+
+std::string readAll(FILE* file) {
+    std::string text;
+    char buffer[4096];
+    rewind(file);
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0;) text.append(buffer, n);
+    return text;
+}
+
+size_t countOf(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) count++;
+    return count;
+}
+
+void testFormatting() {
+    FILE* file = tmpfile();
+    Logger::instance().setOutput(file);
+
+    LOG_INFO("plain\n");
+    LOG_INFO("value %lu of %ld in %s\n", 7, -3, "ring");
+    logFlush();
+
+    std::string text = readAll(file);
+    assert(countOf(text, "] plain\n") == 1);
+    assert(countOf(text, "] value 7 of -3 in ring\n") == 1);
+    fclose(file);
+}
+
+void testManyThreads() {
+    FILE* file = tmpfile();
+    Logger::instance().setOutput(file);
+
+    const int numThreads = 4;
+    const int numEvents = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([=]() {
+            for (int i = 0; i < numEvents; i++) LOG_DEBUG("thread %lu event %lu\n", t, i);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    logFlush();
+
+    std::string text = readAll(file);
+    assert(countOf(text, " event ") == numThreads * numEvents);  // Rings outlive their threads
+    assert(countOf(text, "thread 2 event 999\n") == 1);
+    fclose(file);
+}
+
+void testDropWhenFull() {
+    FILE* file = tmpfile();
+    Logger::instance().setOutput(file);
+
+    std::thread([]() {
+        for (int i = 0; i < LOG_RING_DEPTH * 2; i++) LOG_DEBUG("burst %lu\n", i);
+    }).join();
+    logFlush();
+
+    std::string text = readAll(file);
+    size_t written = countOf(text, "] burst ");
+    assert(written >= LOG_RING_DEPTH && written <= LOG_RING_DEPTH * 2);
+    if (written < LOG_RING_DEPTH * 2) assert(countOf(text, "events dropped") >= 1);  // Never blocks, reports the loss
+    Logger::instance().setOutput(stdout);
+    fclose(file);
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testFormatting();
+    std::cout << "Formatting test passed.\n";
+
+    testManyThreads();
+    std::cout << "Many Threads test passed.\n";
+
+    testDropWhenFull();
+    std::cout << "Drop When Full test passed.\n";
+
+    std::cout << "All tests passed.\n";
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <unistd.h>
+#include "perf.hpp"
+
+void testDelta() {
+    PerfSample from, to;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        from.value[i] = 100;
+        to.value[i] = 100 + 10 * i;
+    }
+    PerfSample delta = perfDelta(from, to, 2);
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) assert(delta.value[i] == (uint64_t)(5 * i));
+    assert(perfDelta(to, from).value[NUM_PERF_COUNTERS - 1] == 0);  // Never wraps
+}
+
+void testCounting() {
+    // Whatever the machine offers, counters never run backwards, and context
+    // switches are always counted (perf or getrusage)
+    PerfCounters counters;
+    assert(counters.available() & (1u << PERF_CONTEXT_SWITCHES));
+
+    PerfSample before, after;
+    assert(counters.read(before));
+    volatile uint64_t sink = 0;
+    for (int i = 0; i < 1000000; i++) sink += i;
+    for (int i = 0; i < 5; i++) usleep(1000);
+    assert(counters.read(after));
+
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        assert(after.value[i] >= before.value[i]);
+        if (!(counters.available() & (1u << i))) assert(after.value[i] == 0);
+    }
+    assert(after.value[PERF_CONTEXT_SWITCHES] - before.value[PERF_CONTEXT_SWITCHES] >= 5);
+    if (counters.available() & (1u << PERF_INSTRUCTIONS)) {
+        assert(after.value[PERF_INSTRUCTIONS] - before.value[PERF_INSTRUCTIONS] >= 1000000);
+    }
+}
+
+void testPerThread() {
+    // Each thread counts only itself
+    PerfCounters counters;
+    PerfSample before, after;
+    assert(counters.read(before));
+    std::thread sleeper([]() { for (int i = 0; i < 5; i++) usleep(1000); });
+    sleeper.join();
+    assert(counters.read(after));
+    assert(after.value[PERF_CONTEXT_SWITCHES] - before.value[PERF_CONTEXT_SWITCHES] <= 3);
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testDelta();
+    std::cout << "Delta test passed.\n";
+
+    testCounting();
+    std::cout << "Counting test passed.\n";
+
+    testPerThread();
+    std::cout << "Per-thread test passed.\n";
+
+    std::cout << "All tests passed.\n";
+
+    return 0;
+}
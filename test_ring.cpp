@@ -0,0 +1,90 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "ring.hpp"
+
+void testPushPop() {
+    static BoundedRing<uint32_t, 4> ring;
+    ring.init();
+
+    uint32_t value;
+    assert(ring.pop(value) == false);  // Empty ring
+
+    for (uint32_t i = 0; i < 4; i++) {
+        assert(ring.push(i) == true);
+    }
+    assert(ring.push(99) == false);    // Full ring
+    assert(ring.size() == 4);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        assert(ring.pop(value) == true);
+        assert(value == i);            // FIFO order
+    }
+    assert(ring.pop(value) == false);
+}
+
+void testWrapAround() {
+    static BoundedRing<uint32_t, 2> ring;
+    ring.init();
+
+    uint32_t value;
+    for (uint32_t i = 0; i < 100; i++) {
+        assert(ring.push(i) == true);
+        assert(ring.pop(value) == true);
+        assert(value == i);
+    }
+}
+
+void testConcurrentProducersConsumers() {
+    static BoundedRing<uint64_t, 64> ring;
+    ring.init();
+
+    const int numThreads = 4;
+    const uint64_t perThread = 20000;
+    std::atomic<uint64_t> sum(0);
+    std::atomic<uint64_t> popped(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&]() {
+            for (uint64_t i = 1; i <= perThread; i++) {
+                while (!ring.push(i)) { std::this_thread::yield(); }
+            }
+        });
+        threads.emplace_back([&]() {
+            uint64_t value;
+            while (popped.load() < numThreads * perThread) {
+                if (ring.pop(value)) {
+                    sum += value;
+                    popped++;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    assert(popped.load() == numThreads * perThread);
+    assert(sum.load() == numThreads * perThread * (perThread + 1) / 2);  // Nothing lost or duplicated
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testPushPop();
+    std::cout << "Push and Pop test passed.\n";
+
+    testWrapAround();
+    std::cout << "Wrap Around test passed.\n";
+
+    testConcurrentProducersConsumers();
+    std::cout << "Concurrent Producers and Consumers test passed.\n";
+
+    std::cout << "All tests passed.\n";
+
+    return 0;
+}
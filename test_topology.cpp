@@ -0,0 +1,45 @@
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include "topology.hpp"
+
+void testParseCpuList() {
+    assert(parseCpuList("") == std::vector<int>{});
+    assert(parseCpuList("3") == std::vector<int>{3});
+    assert((parseCpuList("0-3,8,10-11\n") == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+}
+
+void testPlacementOrder() {
+    Topology topology;
+    assert(topology.nodes() >= 1);
+
+    for (int node = 0; node < 64; node++) {
+        if (!topology.hasNode(node)) continue;
+        std::vector<int> order = topology.placementOrder(node);
+        assert(!order.empty());
+        assert(topology.nodeOf(order.front()) == node);   // Home node comes first
+
+        std::vector<int> sorted = order;
+        std::sort(sorted.begin(), sorted.end());
+        assert(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());  // Every CPU once
+
+        for (int cpu : topology.cpusOf(node)) {
+            assert(std::find(order.begin(), order.end(), cpu) != order.end());
+        }
+    }
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testParseCpuList();
+    std::cout << "Parse CPU List test passed.\n";
+
+    testPlacementOrder();
+    std::cout << "Placement Order test passed.\n";
+
+    std::cout << "All tests passed.\n";
+
+    return 0;
+}
@@ -0,0 +1,255 @@
+#include <iostream>
+#include <cassert>
+#include <map>
+#include <set>
+#include <string>
+#include "workload.hpp"
+
+#define STREAM 200000
+
+std::map<OperationType, size_t> countOps(Workload::Cursor cursor, size_t n) {
+    std::map<OperationType, size_t> counts;
+    for (size_t i = 0; i < n; i++) counts[cursor.next().operation]++;
+    return counts;
+}
+
+// Past the load phase, where the operation mix starts.
+Workload::Cursor mixCursor(const Workload& workload) {
+    Workload::Cursor cursor = workload.cursor();
+    while (cursor.loading()) cursor.next();
+    return cursor;
+}
+
+void testDefaultMix() {
+    // Equal thirds over uniform keys of 1 to 6 characters, like the old generator
+    WorkloadSpec spec;
+    spec.seed = 1;
+    Workload workload(spec, STREAM);
+    assert(workload.poolSize() == DEFAULT_KEY_POOL);
+    assert(workload.loadSize() == 0);
+
+    Workload::Cursor cursor = workload.cursor();
+    std::map<OperationType, size_t> counts;
+    for (size_t i = 0; i < STREAM; i++) {
+        WorkloadOp op = cursor.next();
+        assert(op.key.size() >= 1 && op.key.size() <= 6);
+        for (char c : op.key) assert(c >= 'a' && c <= 'z');
+        counts[op.operation]++;
+    }
+    for (OperationType operation : {INSERT, READ, DELETE}) {
+        assert(counts[operation] > STREAM * 0.31 && counts[operation] < STREAM * 0.36);
+    }
+}
+
+void testZipfian() {
+    // The most popular key is drawn far more often than under a uniform draw,
+    // and the top 1% of keys take a large share
+    WorkloadSpec spec;
+    spec.seed = 2;
+    assert(spec.setKeys("zipfian"));
+    assert(spec.setMix("read=1"));
+    Workload workload(spec, STREAM);
+    std::map<std::string_view, size_t> hits;
+    Workload::Cursor cursor = workload.cursor();
+    for (size_t i = 0; i < STREAM; i++) hits[cursor.next().key]++;
+
+    std::vector<size_t> sorted;
+    for (auto& entry : hits) sorted.push_back(entry.second);
+    std::sort(sorted.rbegin(), sorted.rend());
+    size_t top = 0;
+    for (size_t i = 0; i < DEFAULT_KEY_POOL / 100 && i < sorted.size(); i++) top += sorted[i];
+    assert(sorted[0] > STREAM / 100);
+    assert(top > STREAM * 0.4);
+}
+
+void testHotspot() {
+    WorkloadSpec spec;
+    spec.seed = 3;
+    spec.poolSize = 1000;
+    spec.lengths = LENGTH_FIXED;
+    spec.lengthA = spec.lengthB = 8;    // Long enough that pool keys are distinct
+    spec.load = true;
+    assert(spec.setKeys("hotspot:0.1,0.9"));
+    Workload workload(spec, STREAM);
+
+    // The load phase walks the pool in order, so the hot keys come first
+    Workload::Cursor cursor = workload.cursor();
+    std::set<std::string_view> hot;
+    for (size_t i = 0; i < workload.loadSize(); i++) {
+        WorkloadOp op = cursor.next();
+        if (i < 100) hot.insert(op.key);
+    }
+    assert(hot.size() == 100);
+
+    size_t hits = 0;
+    for (size_t i = 0; i < STREAM; i++) hits += hot.count(cursor.next().key);
+    assert(hits > STREAM * 0.88 && hits < STREAM * 0.92);
+}
+
+void testYcsb() {
+    // A: half the draws are updates, each a DELETE then an INSERT of one key
+    WorkloadSpec spec;
+    spec.seed = 4;
+    assert(spec.setYcsb("A"));
+    assert(spec.load);                  // Every YCSB workload loads the table first
+    Workload a(spec, STREAM);
+    Workload::Cursor cursor = mixCursor(a);
+    std::map<OperationType, size_t> counts;
+    for (size_t i = 0; i < STREAM; i++) {
+        WorkloadOp op = cursor.next();
+        counts[op.operation]++;
+        if (op.operation == DELETE) {
+            WorkloadOp insert = cursor.next();
+            assert(insert.operation == INSERT && insert.key == op.key);
+            counts[INSERT]++;
+            i++;
+        }
+    }
+    assert(counts[READ] > STREAM * 0.31 && counts[READ] < STREAM * 0.36);
+    assert(counts[INSERT] == counts[DELETE]);
+
+    // C is read only
+    assert(spec.setYcsb("c"));
+    assert(countOps(mixCursor(Workload(spec, 1000)), 1000)[READ] == 1000);
+
+    // F: read-modify-write is READ, DELETE, INSERT of one key
+    assert(spec.setYcsb("F"));
+    Workload f(spec, STREAM);
+    cursor = mixCursor(f);
+    for (size_t i = 0; i < 1000; i++) {
+        WorkloadOp op = cursor.next();
+        if (op.operation != DELETE) continue;
+        WorkloadOp insert = cursor.next();
+        assert(insert.operation == INSERT && insert.key == op.key);
+    }
+
+    assert(!spec.setYcsb("G"));
+}
+
+void testLatest() {
+    // D: inserts add keys not seen before, and reads favour the newest keys
+    WorkloadSpec spec;
+    spec.seed = 5;
+    spec.poolSize = 100000;
+    spec.lengths = LENGTH_FIXED;
+    spec.lengthA = spec.lengthB = 12;
+    spec.load = true;
+    assert(spec.setYcsb("D"));
+    Workload workload(spec, STREAM);
+    assert(workload.loadSize() == spec.poolSize / 2);
+
+    Workload::Cursor cursor = workload.cursor();
+    std::set<std::string_view> live;
+    std::vector<std::string_view> order;
+    while (cursor.loading()) {
+        WorkloadOp op = cursor.next();
+        assert(op.operation == INSERT);
+        live.insert(op.key);
+        order.push_back(op.key);
+    }
+    size_t recentReads = 0, reads = 0;
+    for (size_t i = 0; i < STREAM / 4; i++) {
+        WorkloadOp op = cursor.next();
+        if (op.operation == INSERT) {
+            assert(live.insert(op.key).second);
+            order.push_back(op.key);
+            continue;
+        }
+        assert(op.operation == READ);
+        assert(live.count(op.key));
+        reads++;
+        auto position = std::find(order.end() - std::min<size_t>(order.size(), 1000), order.end(), op.key);
+        if (position != order.end()) recentReads++;
+    }
+    assert(recentReads > reads * 0.5);
+}
+
+void testLoadSplit() {
+    // Every initially live key is loaded exactly once across the cursors
+    WorkloadSpec spec;
+    spec.seed = 6;
+    spec.poolSize = 1000;
+    spec.load = true;
+    Workload workload(spec, 1000);
+    size_t loaded = 0;
+    for (size_t c = 0; c < 3; c++) {
+        Workload::Cursor cursor = workload.cursor(c, 3);
+        while (cursor.loading()) {
+            assert(cursor.next().operation == INSERT);
+            loaded++;
+        }
+    }
+    assert(loaded == 1000);
+}
+
+void testKeyLengths() {
+    WorkloadSpec spec;
+    spec.seed = 7;
+    spec.poolSize = 10000;
+    assert(spec.setLengths("fixed:16"));
+    Workload fixed(spec, 1000);
+    Workload::Cursor cursor = fixed.cursor();
+    for (size_t i = 0; i < 1000; i++) assert(cursor.next().key.size() == 16);
+
+    // Normal lengths are clamped to what a request holds
+    assert(spec.setLengths("normal:40,100"));
+    Workload normal(spec, STREAM);
+    cursor = normal.cursor();
+    bool clamped = false;
+    for (size_t i = 0; i < 10000; i++) {
+        size_t length = cursor.next().key.size();
+        assert(length >= 1 && length <= MAX_KEY_LEN);
+        clamped |= length == 1;
+    }
+    assert(clamped);
+
+    assert(!spec.setLengths("uniform:5-2"));
+    assert(!spec.setLengths("fixed:300"));
+    assert(!spec.setMix("read=1,scan=1"));
+    assert(!spec.setKeys("zipfian:1.5"));
+}
+
+void testSeed() {
+    // The same seed gives the same keys and operations
+    WorkloadSpec spec;
+    spec.seed = 8;
+    spec.setKeys("zipfian");
+    Workload first(spec, 1000), second(spec, 1000);
+    Workload::Cursor a = first.cursor(), b = second.cursor();
+    for (size_t i = 0; i < 1000; i++) {
+        WorkloadOp x = a.next(), y = b.next();
+        assert(x.operation == y.operation && x.key == y.key);
+    }
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testDefaultMix();
+    std::cout << "Default Mix test passed.\n";
+
+    testZipfian();
+    std::cout << "Zipfian test passed.\n";
+
+    testHotspot();
+    std::cout << "Hotspot test passed.\n";
+
+    testYcsb();
+    std::cout << "YCSB test passed.\n";
+
+    testLatest();
+    std::cout << "Latest test passed.\n";
+
+    testLoadSplit();
+    std::cout << "Load Split test passed.\n";
+
+    testKeyLengths();
+    std::cout << "Key Lengths test passed.\n";
+
+    testSeed();
+    std::cout << "Seed test passed.\n";
+
+    std::cout << "All tests passed.\n";
+
+    return 0;
+}
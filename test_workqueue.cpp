@@ -0,0 +1,59 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "workqueue.hpp"
+
+void testParkingHandoff() {
+    // spinNs = 0 parks on every empty pop, exercising the doorbell path.
+    static WorkQueue<uint64_t, 8> queue;
+    queue.setSpin(0);
+
+    const uint64_t count = 20000;
+    std::thread consumer([&]() {
+        for (uint64_t i = 1; i <= count; i++) {
+            assert(queue.pop() == i);   // Single producer keeps FIFO order
+        }
+    });
+    for (uint64_t i = 1; i <= count; i++) {
+        queue.push(i);
+    }
+    consumer.join();
+}
+
+void testSpinningHandoffManyConsumers() {
+    static WorkQueue<uint64_t, 64> queue;
+    queue.setSpin(20000);
+
+    const int numConsumers = 3;
+    const uint64_t perConsumer = 10000;
+    std::atomic<uint64_t> sum(0);
+    std::vector<std::thread> consumers;
+    for (int t = 0; t < numConsumers; t++) {
+        consumers.emplace_back([&]() {
+            for (uint64_t i = 0; i < perConsumer; i++) sum += queue.pop();
+        });
+    }
+    const uint64_t total = numConsumers * perConsumer;
+    for (uint64_t i = 1; i <= total; i++) {
+        queue.push(i);
+    }
+    for (auto& consumer : consumers) consumer.join();
+
+    assert(sum.load() == total * (total + 1) / 2);  // No item lost or duplicated
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testParkingHandoff();
+    std::cout << "Parking Handoff test passed.\n";
+
+    testSpinningHandoffManyConsumers();
+    std::cout << "Spinning Handoff with many Consumers test passed.\n";
+
+    std::cout << "All tests passed.\n";
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "wsdeque.hpp"
+
+void testPushSteal() {
+    static StealDeque<uint32_t, 4> deque;
+
+    uint32_t value;
+    assert(deque.steal(value) == false);  // Empty deque
+
+    for (uint32_t i = 0; i < 4; i++) {
+        assert(deque.push(i) == true);
+    }
+    assert(deque.push(99) == false);      // Full deque
+    assert(deque.size() == 4);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        assert(deque.steal(value) == true);
+        assert(value == i);               // Taken from the top in FIFO order
+    }
+    assert(deque.steal(value) == false);
+    assert(deque.push(4) == true);        // Space is reusable after wrap
+}
+
+void testConcurrentThieves() {
+    static StealDeque<uint64_t, 64> deque;
+
+    const int numThieves = 4;
+    const uint64_t total = 100000;
+    std::atomic<uint64_t> sum(0);
+    std::atomic<uint64_t> stolen(0);
+    std::vector<std::thread> thieves;
+
+    for (int t = 0; t < numThieves; t++) {
+        thieves.emplace_back([&]() {
+            uint64_t value;
+            while (stolen.load() < total) {
+                if (deque.steal(value)) {
+                    sum += value;
+                    stolen++;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (uint64_t i = 1; i <= total; i++) {
+        while (!deque.push(i)) { std::this_thread::yield(); }
+    }
+    for (auto& thief : thieves) thief.join();
+
+    assert(stolen.load() == total);
+    assert(sum.load() == total * (total + 1) / 2);  // Every item taken exactly once
+}
+
+int main() {
+    std::cout << "Running tests...\n";
+
+    testPushSteal();
+    std::cout << "Push and Steal test passed.\n";
+
+    testConcurrentThieves();
+    std::cout << "Concurrent Thieves test passed.\n";
+
+    std::cout << "All tests passed.\n";
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+
+// Memory policy wrappers over the raw syscalls, so the server needs no libnuma.
+// `nodes` is a bit mask of NUMA node ids.
+
+inline bool setMemoryPolicy(int mode, uint64_t nodes) {
+    return syscall(SYS_set_mempolicy, mode, mode == MPOL_DEFAULT ? nullptr : &nodes, mode == MPOL_DEFAULT ? 0 : 64) == 0;
+}
+
+// Applies to [addr, addr + length) rounded out to whole pages; pages that were
+// already touched are migrated.
+inline bool bindMemory(void* addr, size_t length, int mode, uint64_t nodes) {
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (uintptr_t)addr & ~(page - 1);
+    uintptr_t end = ((uintptr_t)addr + length + page - 1) & ~(page - 1);
+    return syscall(SYS_mbind, begin, end - begin, mode, &nodes, 64, MPOL_MF_MOVE) == 0;
+}
+
+inline bool pinCurrentThread(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+inline std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range[0] == '\n') continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// CPU and NUMA layout read from /sys/devices/system. Without NUMA entries in
+// sysfs the machine looks like one node holding every online CPU.
+class Topology {
+
+    private:
+
+        struct Cpu {
+            int id;
+            int node;
+            int core;       // physical core, unique across packages
+        };
+
+        std::vector<Cpu> cpus;
+        std::vector<int> nodeIds;                   // nodes with CPUs
+        std::vector<int> onlineIds;                 // every online node, memory-only ones too
+        std::vector<std::vector<int>> distances;    // rows indexed like nodeIds, columns like onlineIds
+
+        static std::string readFile(const std::string& path) {
+            std::ifstream file(path);
+            std::string text;
+            std::getline(file, text);
+            return text;
+        }
+
+        static int readInt(const std::string& path, int fallback) {
+            std::string text = readFile(path);
+            return text.empty() ? fallback : std::stoi(text);
+        }
+
+        int nodeIndex(int node) const {
+            for (size_t i = 0; i < nodeIds.size(); ++i) {
+                if (nodeIds[i] == node) return i;
+            }
+            return 0;
+        }
+
+        // sysfs distance from `from` (a node with CPUs) to `to`; 0 if unknown.
+        int distance(int from, int to) const {
+            const std::vector<int>& row = distances[nodeIndex(from)];
+            for (size_t i = 0; i < onlineIds.size() && i < row.size(); ++i) {
+                if (onlineIds[i] == to) return row[i];
+            }
+            return 0;
+        }
+
+    public:
+
+        Topology() {
+            onlineIds = parseCpuList(readFile("/sys/devices/system/node/online"));
+            for (int node : onlineIds) {
+                std::string dir = "/sys/devices/system/node/node" + std::to_string(node);
+                std::vector<int> nodeCpus = parseCpuList(readFile(dir + "/cpulist"));
+                if (nodeCpus.empty()) continue;     // memory-only node
+                nodeIds.push_back(node);
+                std::vector<int> row;
+                std::stringstream stream(readFile(dir + "/distance"));
+                for (int value; stream >> value;) row.push_back(value);
+                distances.push_back(row);
+                for (int cpu : nodeCpus) cpus.push_back({cpu, node, -1});
+            }
+            if (cpus.empty()) {
+                nodeIds = {0};
+                onlineIds = {0};
+                distances = {{10}};
+                std::vector<int> all = parseCpuList(readFile("/sys/devices/system/cpu/online"));
+                if (all.empty()) {
+                    for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) all.push_back(cpu);
+                }
+                for (int cpu : all) cpus.push_back({cpu, 0, -1});
+            }
+            for (Cpu& cpu : cpus) {
+                std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu.id) + "/topology";
+                int package = readInt(dir + "/physical_package_id", 0);
+                cpu.core = (package << 16) | readInt(dir + "/core_id", cpu.id);
+            }
+        }
+
+        int nodes() const { return nodeIds.size(); }
+
+        bool hasNode(int node) const {
+            return std::find(nodeIds.begin(), nodeIds.end(), node) != nodeIds.end();
+        }
+
+        int nodeOf(int cpu) const {
+            for (const Cpu& entry : cpus) {
+                if (entry.id == cpu) return entry.node;
+            }
+            return nodeIds[0];
+        }
+
+        std::vector<int> cpusOf(int node) const {
+            std::vector<int> result;
+            for (const Cpu& cpu : cpus) {
+                if (cpu.node == node) result.push_back(cpu.id);
+            }
+            return result;
+        }
+
+        // The order threads are handed CPUs in: the home node first, then the
+        // other nodes by distance from it. Within a node every physical core
+        // comes before its hyperthread siblings, so spinning threads do not
+        // share a core until they have to.
+        std::vector<int> placementOrder(int home) const {
+            std::vector<int> order;
+            std::vector<int> byDistance = nodeIds;
+            std::stable_sort(byDistance.begin(), byDistance.end(), [&](int a, int b) {
+                if (a == home || b == home) return a == home && b != home;
+                return distance(home, a) < distance(home, b);
+            });
+            for (int node : byDistance) {
+                std::vector<int> cores;
+                std::vector<int> siblings;
+                for (const Cpu& cpu : cpus) {
+                    if (cpu.node != node) continue;
+                    bool seen = false;
+                    for (const Cpu& other : cpus) {
+                        if (other.id == cpu.id) break;
+                        if (other.core == cpu.core) seen = true;
+                    }
+                    (seen ? siblings : cores).push_back(cpu.id);
+                }
+                order.insert(order.end(), cores.begin(), cores.end());
+                order.insert(order.end(), siblings.begin(), siblings.end());
+            }
+            return order;
+        }
+};
+
+#endif
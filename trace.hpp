@@ -0,0 +1,112 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "datatypes.hpp"
+#include "ring.hpp"
+#include "spin.hpp"
+
+#define TRACE_DEPTH 16384   // sampled requests kept for export
+
+// Client-side request tracing. Every TRACE-sampled request carries
+// StageTimes::sampled, so the server stamps all of its stages; the client
+// adds its own create/receive times when the response arrives, keeping the
+// whole cross-process timeline in one record. exportJson() writes the
+// records as Chrome trace-event JSON (chrome://tracing, Perfetto).
+struct TraceRecord {
+    uint64_t requestid;
+    OperationType operation;
+    StageTimes times;
+    uint64_t received;
+};
+
+class Tracer {
+
+    private:
+
+        BoundedRing<TraceRecord, TRACE_DEPTH> records;
+        std::atomic<uint32_t> every{0};
+        std::atomic<uint64_t> dropped{0};
+
+        Tracer() { records.init(); }
+
+        static void span(FILE* out, bool& first, const char* name, int pid, uint64_t tid,
+                         uint64_t from, uint64_t to, uint64_t origin, uint64_t requestid) {
+            if (from == 0 || to < from) return;
+            fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"kv\",\"ph\":\"X\",\"pid\":%d,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"requestid\":%lu}}",
+                    first ? "" : ",", name, pid, (unsigned long)tid, (from - origin) / 1000.0, (to - from) / 1000.0,
+                    (unsigned long)requestid);
+            first = false;
+        }
+
+    public:
+
+        static Tracer& instance() {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        // Trace one request in `n` per thread; 0 turns tracing off.
+        void setSampling(uint32_t n) { every.store(n); }
+
+        // Called when a request starts being built.
+        void begin(StageTimes& times) {
+            thread_local uint32_t count = 0;
+            uint32_t n = every.load(std::memory_order_relaxed);
+            times.sampled = n != 0 && ++count % n == 0;
+            times.created = times.sampled ? monotonicNs() : 0;
+        }
+
+        // Called with the server-stamped times once the response is in.
+        void finish(uint64_t requestid, OperationType operation, const StageTimes& times) {
+            if (!times.sampled) return;
+            TraceRecord record{requestid, operation, times, monotonicNs()};
+            if (!records.push(record)) dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Drains the records into `path`. Client spans go under pid 1 and
+        // server spans under pid 2, one row (tid) per traced request.
+        size_t exportJson(const std::string& path) {
+            FILE* out = fopen(path.c_str(), "w");
+            if (out == nullptr) {
+                perror("fopen");
+                return 0;
+            }
+            static const char* operations[] = {"insert", "read", "delete"};
+            fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+            fprintf(out, "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"client\"}},");
+            fprintf(out, "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"server\"}}");
+            std::vector<TraceRecord> drained;
+            uint64_t origin = UINT64_MAX;
+            for (TraceRecord record; records.pop(record);) {
+                drained.push_back(record);
+                if (record.times.created < origin) origin = record.times.created;
+            }
+            bool first = false;
+            size_t count = 0;
+            for (const TraceRecord& record : drained) {
+                const StageTimes& t = record.times;
+                uint64_t tid = ++count;
+                const char* name = record.operation >= INSERT && record.operation <= DELETE ? operations[record.operation] : "request";
+                span(out, first, name, 1, tid, t.created, record.received, origin, record.requestid);
+                span(out, first, "build", 1, tid, t.created, t.sent, origin, record.requestid);
+                span(out, first, "await response", 1, tid, t.sent, record.received, origin, record.requestid);
+                span(out, first, "ingress wait", 2, tid, t.sent, t.ingress, origin, record.requestid);
+                span(out, first, "queue wait", 2, tid, t.ingress, t.dequeued, origin, record.requestid);
+                span(out, first, "table op", 2, tid, t.op_start, t.executed, origin, record.requestid);
+                span(out, first, "egress", 2, tid, t.executed, t.egress, origin, record.requestid);
+                span(out, first, "delivery", 1, tid, t.egress, record.received, origin, record.requestid);
+            }
+            fprintf(out, "\n]}\n");
+            fclose(out);
+            uint64_t lost = dropped.exchange(0);
+            if (lost != 0) fprintf(stderr, "trace: %lu sampled requests dropped, ring full\n", (unsigned long)lost);
+            return count;
+        }
+};
+
+#endif
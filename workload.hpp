@@ -0,0 +1,354 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "datatypes.hpp"
+#include "capture.hpp"
+
+// Benchmark workloads. Keys come from a pool generated up front, and the
+// whole sequence of operations is generated up front as well (a stream of
+// WORKLOAD_STREAM_OPS operations that each client cursor walks in a loop),
+// so the client spends no time in random number generators between requests.
+//
+// The table stores a set of keys and has no update, so a YCSB update becomes
+// a DELETE followed by an INSERT of the same key, a read-modify-write becomes
+// READ, DELETE, INSERT, and a scan becomes a READ.
+//
+// A workload can instead replay a server capture (capture.hpp) in order,
+// at the recorded pace, scaled, or as fast as the client can send.
+
+#define DEFAULT_KEY_POOL 100000
+#define WORKLOAD_STREAM_OPS (1 << 20)
+#define MAX_KEY_LEN 255                 // Request::value holds the key and its '\0'
+#define DEFAULT_ZIPF_THETA 0.99
+#define DEFAULT_HOT_KEYS 0.2
+#define DEFAULT_HOT_OPS 0.8
+
+enum KeyDistribution {
+    KEYS_UNIFORM,
+    KEYS_ZIPFIAN,       // rank 0 most popular, pool order scrambled by the random keys
+    KEYS_HOTSPOT,       // hotOps of the accesses go to the first hotKeys of the keys
+    KEYS_LATEST         // zipfian over insertion order, newest most popular
+};
+
+enum LengthDistribution {
+    LENGTH_FIXED,
+    LENGTH_UNIFORM,
+    LENGTH_NORMAL
+};
+
+struct WorkloadOp {
+    OperationType operation;
+    std::string_view key;
+};
+
+struct WorkloadSpec {
+    // Relative weights; update and rmw expand into several operations.
+    double read = 1, insert = 1, remove = 1, update = 0, rmw = 0;
+    bool insertNew = false;             // INSERTs add new keys (YCSB D and E) instead of reusing live ones
+    KeyDistribution keys = KEYS_UNIFORM;
+    double theta = DEFAULT_ZIPF_THETA;
+    double hotKeys = DEFAULT_HOT_KEYS;
+    double hotOps = DEFAULT_HOT_OPS;
+    size_t poolSize = DEFAULT_KEY_POOL;
+    LengthDistribution lengths = LENGTH_UNIFORM;
+    double lengthA = 1, lengthB = 6;    // fixed: A; uniform: A..B; normal: mean A, stddev B
+    bool load = false;                  // INSERT the initially live keys before the mix starts
+    uint64_t seed = 0;                  // 0: random
+
+    // --ycsb A..F
+    bool setYcsb(const std::string& name) {
+        if (name.size() != 1) return false;
+        read = insert = remove = update = rmw = 0;
+        insertNew = false;
+        keys = KEYS_ZIPFIAN;
+        load = true;        // YCSB runs against a loaded table; reads of an empty one only miss
+        switch (name[0] & ~0x20) {
+            case 'A': read = 0.5; update = 0.5; break;
+            case 'B': read = 0.95; update = 0.05; break;
+            case 'C': read = 1; break;
+            case 'D': read = 0.95; insert = 0.05; insertNew = true; keys = KEYS_LATEST; break;
+            case 'E': read = 0.95; insert = 0.05; insertNew = true; break;
+            case 'F': read = 0.5; rmw = 0.5; break;
+            default: return false;
+        }
+        return true;
+    }
+
+    // --mix read=50,insert=25,delete=25[,update=..,rmw=..]
+    bool setMix(const std::string& text) {
+        double r = 0, i = 0, d = 0, u = 0, m = 0;
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find(',', start);
+            if (end == std::string::npos) end = text.size();
+            std::string item = text.substr(start, end - start);
+            size_t equals = item.find('=');
+            if (equals == std::string::npos) return false;
+            std::string name = item.substr(0, equals);
+            double weight = std::stod(item.substr(equals + 1));
+            if (weight < 0) return false;
+            if (name == "read") r = weight;
+            else if (name == "insert") i = weight;
+            else if (name == "delete") d = weight;
+            else if (name == "update") u = weight;
+            else if (name == "rmw") m = weight;
+            else return false;
+            start = end + 1;
+        }
+        if (r + i + d + u + m <= 0) return false;
+        read = r; insert = i; remove = d; update = u; rmw = m;
+        return true;
+    }
+
+    // --keys uniform | zipfian[:theta] | hotspot[:keys,ops] | latest[:theta]
+    bool setKeys(const std::string& text) {
+        size_t colon = text.find(':');
+        std::string name = text.substr(0, colon);
+        std::string args = colon == std::string::npos ? "" : text.substr(colon + 1);
+        if (name == "uniform") keys = KEYS_UNIFORM;
+        else if (name == "zipfian") keys = KEYS_ZIPFIAN;
+        else if (name == "latest") keys = KEYS_LATEST;
+        else if (name == "hotspot") keys = KEYS_HOTSPOT;
+        else return false;
+        if (args.empty()) return true;
+        if (keys == KEYS_HOTSPOT) {
+            size_t comma = args.find(',');
+            if (comma == std::string::npos) return false;
+            hotKeys = std::stod(args.substr(0, comma));
+            hotOps = std::stod(args.substr(comma + 1));
+            return hotKeys > 0 && hotKeys <= 1 && hotOps >= 0 && hotOps <= 1;
+        }
+        if (keys == KEYS_UNIFORM) return false;
+        theta = std::stod(args);
+        return theta > 0 && theta < 1;
+    }
+
+    // --key-len fixed:n | uniform:min-max | normal:mean,stddev
+    bool setLengths(const std::string& text) {
+        size_t colon = text.find(':');
+        if (colon == std::string::npos) return false;
+        std::string name = text.substr(0, colon);
+        std::string args = text.substr(colon + 1);
+        if (name == "fixed") {
+            lengths = LENGTH_FIXED;
+            lengthA = lengthB = std::stod(args);
+        }
+        else if (name == "uniform" || name == "normal") {
+            size_t split = args.find(name == "uniform" ? '-' : ',');
+            if (split == std::string::npos) return false;
+            lengths = name == "uniform" ? LENGTH_UNIFORM : LENGTH_NORMAL;
+            lengthA = std::stod(args.substr(0, split));
+            lengthB = std::stod(args.substr(split + 1));
+        }
+        else return false;
+        if (lengths == LENGTH_NORMAL) return lengthA >= 1 && lengthA <= MAX_KEY_LEN && lengthB >= 0;
+        return lengthA >= 1 && lengthB >= lengthA && lengthB <= MAX_KEY_LEN;
+    }
+};
+
+// YCSB's zipfian generator (Gray et al., "Quickly generating billion-record
+// synthetic databases"): ranks in [0, n), rank 0 most popular. The item
+// count may grow, for the latest distribution; zeta is extended incrementally.
+class ZipfianGenerator {
+
+    private:
+
+        double theta;
+        double alpha;
+        double zeta2;
+        double zetan = 0;
+        uint64_t items = 0;
+        double eta = 0;
+
+        void grow(uint64_t n) {
+            for (uint64_t i = items + 1; i <= n; ++i) zetan += 1.0 / std::pow((double)i, theta);
+            items = n;
+            eta = (1 - std::pow(2.0 / items, 1 - theta)) / (1 - zeta2 / zetan);
+        }
+
+    public:
+
+        ZipfianGenerator(uint64_t n, double theta): theta(theta), alpha(1 / (1 - theta)), zeta2(1 + std::pow(0.5, theta)) {
+            grow(std::max<uint64_t>(n, 2));
+        }
+
+        template <typename Generator>
+        uint64_t next(Generator& generator, uint64_t n) {
+            if (n > items) grow(n);
+            double u = std::uniform_real_distribution<double>(0, 1)(generator);
+            double uz = u * zetan;
+            if (uz < 1) return 0;
+            if (uz < zeta2) return std::min<uint64_t>(1, n - 1);
+            uint64_t rank = (uint64_t)(n * std::pow(eta * u - eta + 1, alpha));
+            return std::min(rank, n - 1);
+        }
+};
+
+class Workload {
+
+    private:
+
+        struct Step {
+            uint32_t key;
+            OperationType operation;
+        };
+
+        std::vector<char> keyBytes;     // pool keys back to back
+        std::vector<uint32_t> keyStart; // poolSize + 1 offsets into keyBytes
+        std::vector<Step> stream;
+        size_t initial;                 // keys live before the stream starts
+
+        const CaptureReader* replay = nullptr;
+        double replaySpeed = 0;         // 1 recorded pace, 2 twice as fast, 0 no pacing
+        uint64_t replayFirst = 0;       // capture time of the first record
+        uint64_t replaySpan = 0;        // one pass through the capture, at recorded pace
+        mutable std::atomic<uint64_t> replayStart{0};
+
+        std::string_view key(uint32_t index) const {
+            return std::string_view(keyBytes.data() + keyStart[index], keyStart[index + 1] - keyStart[index]);
+        }
+
+        // Takes capture record `position` and advances it by `step`, first
+        // sleeping until the record is due. The clock starts at the first
+        // record any cursor takes; every pass through the capture adds a span.
+        WorkloadOp replayNext(size_t& position, size_t step, uint64_t& laps) const {
+            CaptureReader::Entry entry = replay->at(position);
+            if (replaySpeed > 0) {
+                uint64_t start = replayStart.load(std::memory_order_relaxed);
+                if (start == 0) {
+                    uint64_t now = monotonicNs();
+                    start = replayStart.compare_exchange_strong(start, now) ? now : start;
+                }
+                uint64_t offset = laps * replaySpan + (entry.timeNs > replayFirst ? entry.timeNs - replayFirst : 0);
+                uint64_t due = start + (uint64_t)(offset / replaySpeed);
+                struct timespec until = {(time_t)(due / 1000000000), (long)(due % 1000000000)};
+                if (due > monotonicNs()) clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr);
+            }
+            position += step;
+            if (position >= replay->size()) {
+                position %= replay->size();
+                laps++;
+            }
+            return {entry.operation, entry.key};
+        }
+
+    public:
+
+        explicit Workload(const WorkloadSpec& spec, size_t streamOps = WORKLOAD_STREAM_OPS) {
+            std::mt19937_64 generator(spec.seed != 0 ? spec.seed : std::random_device()());
+            size_t poolSize = std::max<size_t>(spec.poolSize, 1);
+
+            std::uniform_int_distribution<char> charDist('a', 'z');
+            keyStart.reserve(poolSize + 1);
+            for (size_t i = 0; i < poolSize; ++i) {
+                int length = (int)spec.lengthA;
+                if (spec.lengths == LENGTH_UNIFORM) length = std::uniform_int_distribution<int>((int)spec.lengthA, (int)spec.lengthB)(generator);
+                else if (spec.lengths == LENGTH_NORMAL) length = (int)std::lround(std::normal_distribution<double>(spec.lengthA, spec.lengthB)(generator));
+                length = std::max(1, std::min(length, MAX_KEY_LEN));
+                keyStart.push_back(keyBytes.size());
+                for (int c = 0; c < length; ++c) keyBytes.push_back(charDist(generator));
+            }
+            keyStart.push_back(keyBytes.size());
+
+            // Keys [liveStart, liveStart + live) of the pool, taken circularly,
+            // exist; new inserts extend the window and push out the oldest.
+            initial = spec.insertNew ? std::max<size_t>(poolSize / 2, 1) : poolSize;
+            uint64_t inserted = initial;
+            ZipfianGenerator zipfian(2, spec.theta);     // sized on first use
+            std::uniform_real_distribution<double> unit(0, 1);
+            auto pick = [&]() -> uint32_t {
+                uint64_t live = std::min<uint64_t>(inserted, poolSize);
+                uint64_t liveStart = inserted - live;
+                uint64_t offset;
+                if (spec.keys == KEYS_ZIPFIAN) offset = zipfian.next(generator, live);
+                else if (spec.keys == KEYS_LATEST) offset = live - 1 - zipfian.next(generator, live);
+                else if (spec.keys == KEYS_HOTSPOT) {
+                    uint64_t hot = std::max<uint64_t>(1, (uint64_t)(live * spec.hotKeys));
+                    bool toHot = unit(generator) < spec.hotOps || hot == live;
+                    offset = toHot ? (uint64_t)(unit(generator) * hot) : hot + (uint64_t)(unit(generator) * (live - hot));
+                    offset = std::min(offset, live - 1);
+                }
+                else offset = (uint64_t)(unit(generator) * live) % live;
+                return (uint32_t)((liveStart + offset) % poolSize);
+            };
+
+            double total = spec.read + spec.insert + spec.remove + spec.update + spec.rmw;
+            stream.reserve(streamOps + 2);
+            while (stream.size() < streamOps) {
+                double choice = unit(generator) * total;
+                if ((choice -= spec.read) < 0) stream.push_back({pick(), READ});
+                else if ((choice -= spec.insert) < 0) {
+                    if (spec.insertNew) stream.push_back({(uint32_t)(inserted++ % poolSize), INSERT});
+                    else stream.push_back({pick(), INSERT});
+                }
+                else if ((choice -= spec.remove) < 0) stream.push_back({pick(), DELETE});
+                else {
+                    uint32_t chosen = pick();
+                    if (choice - spec.update >= 0) stream.push_back({chosen, READ});
+                    stream.push_back({chosen, DELETE});
+                    stream.push_back({chosen, INSERT});
+                }
+            }
+            if (!spec.load) initial = 0;
+        }
+
+        // Replays `capture` (at least one record), which must outlive the workload.
+        Workload(const CaptureReader& capture, double speed): initial(0), replay(&capture), replaySpeed(speed) {
+            replayFirst = capture.at(0).timeNs;
+            uint64_t last = capture.at(capture.size() - 1).timeNs;
+            // One average gap after the last record before the next pass.
+            replaySpan = (last > replayFirst ? last - replayFirst : 0) * capture.size() / std::max<size_t>(capture.size() - 1, 1) + 1;
+        }
+
+        size_t poolSize() const { return replay != nullptr ? 0 : keyStart.size() - 1; }
+        size_t streamSize() const { return replay != nullptr ? replay->size() : stream.size(); }
+        size_t loadSize() const { return initial; }
+
+        // One client's position in the workload. Cursor `index` of `count`
+        // first loads every count-th initially live key, then starts the
+        // stream at its own offset so clients do not move in lockstep. In a
+        // replay it takes every count-th record instead, keeping their order.
+        class Cursor {
+
+            private:
+
+                const Workload* workload;
+                size_t loadNext;
+                size_t loadStep;
+                size_t position;
+                uint64_t laps = 0;
+
+            public:
+
+                Cursor(const Workload& workload, size_t index, size_t count)
+                    : workload(&workload), loadNext(index), loadStep(std::max<size_t>(count, 1)),
+                      position(workload.replay != nullptr ? (index % loadStep) % workload.replay->size()
+                                                          : workload.stream.size() / loadStep * (index % loadStep)) {}
+
+                WorkloadOp next() {
+                    if (workload->replay != nullptr) return workload->replayNext(position, loadStep, laps);
+                    if (loadNext < workload->initial) {
+                        uint32_t index = loadNext;
+                        loadNext += loadStep;
+                        return {INSERT, workload->key(index)};
+                    }
+                    const Step& step = workload->stream[position];
+                    if (++position == workload->stream.size()) position = 0;
+                    return {step.operation, workload->key(step.key)};
+                }
+
+                bool loading() const { return loadNext < workload->initial; }
+        };
+
+        Cursor cursor(size_t index = 0, size_t count = 1) const { return Cursor(*this, index, count); }
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include "ring.hpp"
+#include "spin.hpp"
+
+// Hand-off queue between server stages. Items travel through a lock-free
+// BoundedRing; a consumer only parks on the Doorbell when the ring is empty,
+// and a producer only makes a syscall when some consumer is parked. setSpin()
+// lets consumers poll for a while before parking (busy-poll mode).
+//
+// Capacity is fixed: a push into a full ring waits for a consumer to make room.
+template <typename T, size_t N>
+class WorkQueue {
+
+    private:
+
+        BoundedRing<T, N> ring;
+        alignas(64) Doorbell bell;
+        uint64_t spinNs = 0;
+
+    public:
+
+        WorkQueue() {
+            ring.init();
+            bell.init();
+        }
+        WorkQueue(const WorkQueue&) = delete;
+        WorkQueue& operator=(const WorkQueue&) = delete;
+
+        void setSpin(uint64_t ns) { spinNs = ns; }
+
+        void push(const T& item) {
+            while (!ring.push(item)) std::this_thread::yield();
+            bell.ring();
+        }
+
+        // Publishes `count` items with one wakeup. If the ring fills up midway,
+        // consumers are woken before the producer waits for room.
+        void pushBatch(const T* items, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                while (!ring.push(items[i])) {
+                    bell.ring(count);
+                    std::this_thread::yield();
+                }
+            }
+            bell.ring(count);
+        }
+
+        T pop() {
+            T item;
+            spinThenPark(bell, spinNs, [&]() { return ring.pop(item); });
+            return item;
+        }
+
+        // Waits for one item like pop(), then takes whatever else is already
+        // queued, up to `max`.
+        size_t popBatch(T* items, size_t max) {
+            spinThenPark(bell, spinNs, [&]() { return ring.pop(items[0]); });
+            size_t count = 1;
+            while (count < max && ring.pop(items[count])) ++count;
+            return count;
+        }
+
+        bool tryPop(T& item) { return ring.pop(item); }
+
+        size_t size() const { return ring.size(); }
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef WSDEQUE_H
+#define WSDEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Bounded Chase-Lev work-stealing deque. A single producer pushes at the
+// bottom; any number of consumers take from the top with one CAS each.
+//
+// In the server the producer is the ingress thread rather than the worker
+// itself, so the owner-side popBottom() of the original algorithm is not
+// needed: the worker owning the deque and idle workers stealing from it all
+// use steal(), and requests keep their FIFO order.
+template <typename T, size_t N>
+class StealDeque {
+
+    static_assert(N > 0 && (N & (N - 1)) == 0, "deque size must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "deque items are copied through atomics");
+
+    private:
+
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        alignas(64) std::atomic<T> items[N];
+
+    public:
+
+        // Producer only. Returns false when the deque is full.
+        bool push(const T& item) {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            if (b - t >= (int64_t)N) return false;
+            items[b & (N - 1)].store(item, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Any thread. Returns false when the deque is empty or another
+        // consumer won the race for the top item.
+        bool steal(T& item) {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b) return false;
+            T candidate = items[t & (N - 1)].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return false;
+            item = candidate;
+            return true;
+        }
+
+        size_t size() const {
+            int64_t b = bottom.load(std::memory_order_acquire);
+            int64_t t = top.load(std::memory_order_acquire);
+            return b > t ? (size_t)(b - t) : 0;
+        }
+};
+
+#endif